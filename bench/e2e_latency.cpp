@@ -0,0 +1,168 @@
+// File: bench/e2e_latency.cpp
+//
+// End-to-end latency harness. Plays the IQFeed L1 server on the L1 port
+// and a WebSocket client of a running ingest_server, and reports how long
+// each quote took from our socket write to its arrival as a WebSocket
+// message:
+//
+//   ingest_server &                      # live mode, default ports
+//   e2e_latency --rate 50000 --seconds 10
+//
+// Each Q row carries its send time (ns) in the "Message Contents" column,
+// which ingest_server passes through untouched. Both ends share a clock,
+// so the figure is wire-to-wire: socket read, decode, serialize, fan-out
+// and WebSocket write, plus two loopback hops.
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asio = boost::asio;
+namespace ws   = boost::beast::websocket;
+using tcp      = asio::ip::tcp;
+
+namespace {
+
+struct HarnessOptions {
+    double         rate{10000};      ///< quotes per second
+    double         seconds{10};
+    double         warmup{1};        ///< seconds excluded from the stats
+    std::size_t    symbols{100};
+    unsigned short l1Port{5009};
+    unsigned short wsPort{8080};
+};
+
+std::int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+HarnessOptions parseArgs(int argc, char* argv[]) {
+    HarnessOptions o;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        const char* v = argv[i + 1];
+        if      (arg == "--rate")    o.rate    = std::stod(v);
+        else if (arg == "--seconds") o.seconds = std::stod(v);
+        else if (arg == "--warmup")  o.warmup  = std::stod(v);
+        else if (arg == "--symbols") o.symbols = std::stoul(v);
+        else if (arg == "--l1-port") o.l1Port  = static_cast<unsigned short>(std::stoul(v));
+        else if (arg == "--ws-port") o.wsPort  = static_cast<unsigned short>(std::stoul(v));
+        else throw std::runtime_error("unknown argument '" + arg + "'");
+    }
+    return o;
+}
+
+/// Accept ingest_server's L1 connection, do the handshake it expects, then
+/// stream timestamped quotes at the requested rate until `stop`.
+void runFeed(const HarnessOptions& o, std::atomic<bool>& stop, std::atomic<std::uint64_t>& sent) {
+    asio::io_context ioc;
+    tcp::acceptor acceptor(ioc, {asio::ip::make_address("127.0.0.1"), o.l1Port});
+    tcp::socket sock(ioc);
+    std::cout << "e2e: waiting for ingest_server on L1 port " << o.l1Port << "\n";
+    acceptor.accept(sock);
+    asio::write(sock, asio::buffer(std::string("S,SERVER CONNECTED\r\n")));
+
+    const auto start = std::chrono::steady_clock::now();
+    double owed = 0;
+    auto last = start;
+    std::uint64_t n = 0;
+    std::string batch;
+    while (!stop.load()) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        const auto now = std::chrono::steady_clock::now();
+        owed += o.rate * std::chrono::duration<double>(now - last).count();
+        last = now;
+        batch.clear();
+        for (; owed >= 1.0; owed -= 1.0, ++n) {
+            char row[256];
+            const int len = std::snprintf(row, sizeof row,
+                "Q,E2E%04zu,100.00,100,15:34:12.123456,11,1000,99.99,100,100.01,100,,,,,%lld,\r\n",
+                static_cast<std::size_t>(n % o.symbols), static_cast<long long>(nowNs()));
+            batch.append(row, static_cast<std::size_t>(len));
+        }
+        if (!batch.empty()) {
+            boost::system::error_code ec;
+            asio::write(sock, asio::buffer(batch), ec);
+            if (ec) break;
+            sent.store(n);
+        }
+    }
+}
+
+double percentile(const std::vector<std::int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    const auto i = static_cast<std::size_t>(p * (sorted.size() - 1));
+    return sorted[i] / 1000.0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const HarnessOptions o = parseArgs(argc, argv);
+        std::atomic<bool> stop{false};
+        std::atomic<std::uint64_t> sent{0};
+        std::thread feed([&] { runFeed(o, stop, sent); });
+
+        asio::io_context ioc;
+        ws::stream<tcp::socket> client(ioc);
+        for (;;) {
+            boost::system::error_code ec;
+            client.next_layer().connect({asio::ip::make_address("127.0.0.1"), o.wsPort}, ec);
+            if (!ec) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        }
+        client.handshake("127.0.0.1", "/?subscribe=none");
+        client.write(asio::buffer(std::string(R"({"op":"subscribe","feed":"L1","types":["Q"]})")));
+
+        std::vector<std::int64_t> samples;
+        samples.reserve(static_cast<std::size_t>(o.rate * o.seconds) + 1024);
+        boost::beast::flat_buffer buf;
+        rapidjson::Document doc;
+        const auto begin   = std::chrono::steady_clock::now();
+        const auto measure = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                 std::chrono::duration<double>(o.warmup));
+        const auto end     = measure + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                 std::chrono::duration<double>(o.seconds));
+        std::uint64_t received = 0;
+        while (std::chrono::steady_clock::now() < end) {
+            client.read(buf);
+            const std::int64_t arrived = nowNs();
+            const std::string text = boost::beast::buffers_to_string(buf.data());
+            buf.clear();
+            doc.Parse(text.c_str());
+            if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("Message Contents")) continue;
+            const auto& v = doc["Message Contents"];   // a string column
+            if (!v.IsString()) continue;
+            const std::int64_t stamped = std::strtoll(v.GetString(), nullptr, 10);
+            if (stamped <= 0) continue;
+            ++received;
+            if (std::chrono::steady_clock::now() >= measure) samples.push_back(arrived - stamped);
+        }
+        stop = true;
+        feed.join();
+
+        std::sort(samples.begin(), samples.end());
+        std::printf("sent %llu, received %llu, measured %zu\n",
+                    static_cast<unsigned long long>(sent.load()),
+                    static_cast<unsigned long long>(received), samples.size());
+        std::printf("latency us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                    percentile(samples, 0.50), percentile(samples, 0.99),
+                    percentile(samples, 0.999), percentile(samples, 1.0));
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "e2e_latency: " << ex.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,240 @@
+// File: bench/ingest_bench.cpp
+//
+// Micro-benchmarks for the ingest hot path: CSV decode, JSON and binary
+// encoding, WebSocket fan-out and socket line framing.
+//
+//   ingest_bench [--benchmark_filter=<regex>] ...
+#include "BinaryEncoder.h"
+#include "ConnectionManager.h"
+#include "Deflate.h"
+#include "IoContextPool.h"
+#include "MessageDecoder.h"
+#include "SchemaLoader.h"
+#include "WebSocketServer.h"
+#include <benchmark/benchmark.h>
+#include <rapidjson/document.h>
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace asio = boost::asio;
+namespace ws   = boost::beast::websocket;
+using tcp      = asio::ip::tcp;
+
+namespace {
+
+// Row shapes as IQFeed sends them.
+constexpr const char* kL1Quote    = "Q,MSFT,425.15,100,15:34:12.123456,11,18234500,425.14,300,425.16,200,424.00,426.10,423.50,424.80,ba,01";
+constexpr const char* kL2Add      = "3,MSFT,123456789,NSDQ,B,425.14,300,123456789,,15:34:12.123456,2025-06-22";
+constexpr const char* kL2Modify   = "4,MSFT,123456789,NSDQ,B,425.14,200,123456789,,15:34:12.123457,2025-06-22";
+constexpr const char* kL2Remove   = "5,MSFT,123456789,B";
+constexpr const char* kL2Level    = "7,MSFT,,NSDQ,A,425.16,,,1500,15:34:12.123458,2025-06-22";
+
+const Schema& schemaFor(const char* id) {
+    static const bool loaded = [] {
+        SchemaLoader::load("L1", INGEST_CONFIG_DIR "/L1FeedMessages.csv");
+        SchemaLoader::load("L2", INGEST_CONFIG_DIR "/MarketDepthMessages.csv");
+        return true;
+    }();
+    (void)loaded;
+    return SchemaLoader::schema(id);
+}
+
+void BM_Decode(benchmark::State& state, const char* schemaId, const char* row) {
+    const Schema& schema = schemaFor(schemaId);
+    const std::string_view line(row);
+    DecodedMessage msg;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(MessageDecoder::decode(schema, line, msg));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+BENCHMARK_CAPTURE(BM_Decode, l1_quote,  "L1", kL1Quote);
+BENCHMARK_CAPTURE(BM_Decode, l2_add,    "L2", kL2Add);
+BENCHMARK_CAPTURE(BM_Decode, l2_modify, "L2", kL2Modify);
+BENCHMARK_CAPTURE(BM_Decode, l2_remove, "L2", kL2Remove);
+BENCHMARK_CAPTURE(BM_Decode, l2_level,  "L2", kL2Level);
+
+/// Decimal columns must reach clients as JSON numbers, not strings.
+bool decimalsAreNumbers(const DecodedMessage& msg, std::string_view json) {
+    rapidjson::Document doc;
+    doc.Parse(json.data(), json.size());
+    if (doc.HasParseError() || !doc.IsObject()) return false;
+    for (std::size_t idx = 0; idx < msg.schema->fields.size(); ++idx) {
+        if (msg.fields[idx].type != FieldType::Decimal) continue;
+        const auto it = doc.FindMember(msg.schema->fields[idx].c_str());
+        if (it == doc.MemberEnd() || !it->value.IsNumber()) return false;
+    }
+    return true;
+}
+
+/// The same object main.cpp's serialize() writes.
+void BM_SerializeJson(benchmark::State& state, const char* schemaId, const char* row) {
+    DecodedMessage msg;
+    MessageDecoder::decode(schemaFor(schemaId), row, msg);
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> w(sb);
+    w.StartObject();
+    MessageDecoder::writeFields(msg, w);
+    w.EndObject();
+    if (!decimalsAreNumbers(msg, std::string_view(sb.GetString(), sb.GetSize()))) {
+        state.SkipWithError("decimal column not written as a JSON number");
+        return;
+    }
+    for (auto _ : state) {
+        sb.Clear();
+        w.Reset(sb);
+        w.StartObject();
+        MessageDecoder::writeFields(msg, w);
+        w.Key("feed");        w.String(schemaId);
+        w.Key("messageType"); w.String(row, 1);
+        w.Key("seq");         w.Uint64(state.iterations());
+        w.EndObject();
+        benchmark::DoNotOptimize(sb.GetString());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes/msg"] = static_cast<double>(sb.GetSize());
+}
+BENCHMARK_CAPTURE(BM_SerializeJson, l1_quote, "L1", kL1Quote);
+BENCHMARK_CAPTURE(BM_SerializeJson, l2_add,   "L2", kL2Add);
+
+void BM_EncodeBinary(benchmark::State& state, const char* schemaId, const char* row) {
+    DecodedMessage msg;
+    MessageDecoder::decode(schemaFor(schemaId), row, msg);
+    std::string out;
+    for (auto _ : state) {
+        BinaryEncoder::encode(msg, 1, row[0], state.iterations(), false, out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes/msg"] = static_cast<double>(out.size());
+}
+BENCHMARK_CAPTURE(BM_EncodeBinary, l1_quote, "L1", kL1Quote);
+BENCHMARK_CAPTURE(BM_EncodeBinary, l2_add,   "L2", kL2Add);
+
+/// The once-per-message cost of serving compressed sessions.
+void BM_Deflate(benchmark::State& state, const char* schemaId, const char* row) {
+    DecodedMessage msg;
+    MessageDecoder::decode(schemaFor(schemaId), row, msg);
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> w(sb);
+    w.StartObject();
+    MessageDecoder::writeFields(msg, w);
+    w.EndObject();
+    const std::string_view json(sb.GetString(), sb.GetSize());
+    std::string out;
+    bool shrank = false;
+    for (auto _ : state) {
+        shrank = Deflate::compress(json, false, static_cast<int>(state.range(0)), out);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(json.size()));
+    state.counters["ratio"] = shrank ? static_cast<double>(out.size()) / json.size() : 1.0;
+}
+BENCHMARK_CAPTURE(BM_Deflate, l1_quote, "L1", kL1Quote)->Arg(1)->Arg(6);
+
+/// Read and discard frames until the socket closes.
+void drain(ws::stream<tcp::socket>& c, boost::beast::flat_buffer& b) {
+    c.async_read(b, [&c, &b](boost::beast::error_code ec, std::size_t) {
+        if (ec) return;
+        b.clear();
+        drain(c, b);
+    });
+}
+
+/// Publisher-side cost of one broadcast to N connected sessions. Clients
+/// drain their sockets on a separate thread so queues keep moving.
+void BM_BroadcastFanout(benchmark::State& state) {
+    const auto sessions = static_cast<std::size_t>(state.range(0));
+
+    IoContextPool pool(2);
+    WebSocketServer server(pool, 0);
+    server.start();
+    pool.start();
+
+    asio::io_context clientIoc;
+    std::vector<std::unique_ptr<ws::stream<tcp::socket>>> clients;
+    std::vector<std::unique_ptr<boost::beast::flat_buffer>> buffers;
+    for (std::size_t i = 0; i < sessions; ++i) {
+        auto c = std::make_unique<ws::stream<tcp::socket>>(clientIoc);
+        c->next_layer().connect({asio::ip::make_address("127.0.0.1"), server.port()});
+        c->handshake("127.0.0.1", "/");
+        clients.push_back(std::move(c));
+        buffers.push_back(std::make_unique<boost::beast::flat_buffer>());
+    }
+    for (std::size_t i = 0; i < sessions; ++i) drain(*clients[i], *buffers[i]);
+    std::thread clientThread([&] { clientIoc.run(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));   // let sessions join
+
+    const std::string payload = R"({"Symbol":"MSFT","Bid":425.14,"Ask":425.16,"feed":"L1","messageType":"Q","seq":1})";
+    const MessageTag tag{Feed::L1, SymbolTable::intern("MSFT"), 'Q', 0, 0};
+    for (auto _ : state) {
+        server.broadcast(payload, tag);
+    }
+    state.SetItemsProcessed(state.iterations() * sessions);
+
+    for (auto& c : clients) {
+        boost::beast::error_code ec;
+        c->next_layer().close(ec);
+    }
+    clientIoc.stop();
+    clientThread.join();
+    pool.stop();
+    pool.join();
+}
+BENCHMARK(BM_BroadcastFanout)->Arg(1)->Arg(10)->Arg(100)->Arg(1000)->UseRealTime();
+
+/// ConnectionManager read + framing throughput over loopback, 1 MiB of
+/// L2 rows per iteration.
+void BM_LineFraming(benchmark::State& state) {
+    std::string chunk;
+    std::size_t linesPerChunk = 0;
+    while (chunk.size() < (1u << 20)) {
+        chunk += kL2Add;
+        chunk += "\r\n";
+        ++linesPerChunk;
+    }
+
+    asio::io_context ioc;
+    tcp::acceptor acceptor(ioc, {asio::ip::make_address("127.0.0.1"), 0});
+    const unsigned short port = acceptor.local_endpoint().port();
+
+    std::atomic<std::size_t> lines{0};
+    ConnectionManager cm(ioc, "127.0.0.1", port);
+    cm.setBatchHandler([&](const std::vector<std::string_view>& batch) {
+        lines.fetch_add(batch.size(), std::memory_order_release);
+    });
+    cm.start();
+    auto guard = asio::make_work_guard(ioc);
+    std::thread io([&] { ioc.run(); });
+
+    tcp::socket feed(ioc);
+    acceptor.accept(feed);
+
+    std::size_t expected = 0;
+    for (auto _ : state) {
+        asio::write(feed, asio::buffer(chunk));
+        expected += linesPerChunk;
+        while (lines.load(std::memory_order_acquire) < expected) std::this_thread::yield();
+    }
+    state.SetBytesProcessed(state.iterations() * chunk.size());
+    state.SetItemsProcessed(state.iterations() * linesPerChunk);
+
+    asio::post(ioc, [&] { cm.stop(); });
+    guard.reset();
+    ioc.stop();
+    io.join();
+}
+BENCHMARK(BM_LineFraming)->UseRealTime();
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,138 @@
+// File: include/BarAggregator.h
+#pragma once
+
+#include "MessageDecoder.h"
+#include <boost/asio.hpp>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// One OHLCV bar. Prices are the decoder's fixed-point values, integers in
+/// units of 1 / FixedPoint::kScale.
+struct Bar {
+    std::int64_t  startNs{0};   ///< bucket start, ns since the Unix epoch
+    std::int64_t  open{0};
+    std::int64_t  high{0};
+    std::int64_t  low{0};
+    std::int64_t  close{0};
+    std::int64_t  volume{0};
+    double        notional{0};  ///< sum of price × size, for the VWAP
+    std::uint32_t trades{0};    ///< 0 = nothing traded yet
+
+    /// Volume-weighted average price (fixed-point), 0 without volume.
+    std::int64_t vwap() const;
+};
+
+/// Builds time bars per symbol and interval from L1 trades.
+///
+/// Each trade updates the open bar of every interval in place. Bars are
+/// aligned to the wall clock (a 1m bar starts on the minute) and timed by
+/// arrival, as L1 rows carry a trade time but no date. A bar completes
+/// when its interval ends, either on the next trade or on a timer at the
+/// boundary for symbols that went quiet; intervals without trades produce
+/// no bar. The last `history` completed bars of every series are kept in
+/// a ring, all of a symbol's rings side by side in one flat array.
+///
+/// A row is a trade if its "Message Contents" column contains 'C' (last
+/// qualified trade) or 'E' (extended hours). Without that column, a rise
+/// in "Total Volume" marks one. The trade is "Most Recent Trade" at "Most
+/// Recent Trade Size", or at the Total Volume increase if the size is
+/// blank.
+class BarAggregator {
+public:
+    struct Interval {
+        std::int64_t ns;
+        std::string  label;   ///< as configured, e.g. "1m"
+    };
+
+    /// Called for each completed bar, in order per symbol and interval,
+    /// with the aggregator's lock held. seq numbers the BARS stream.
+    using Sink = std::function<void(SymbolId symbol, const Interval& interval,
+                                    const Bar& bar, std::uint64_t seq)>;
+    using BarVisitor = std::function<void(SymbolId symbol, const Interval& interval,
+                                          const Bar& bar)>;
+
+    /// Parse "1s,1m,5m" (units ms, s, m, h; separated by commas or
+    /// spaces). Bad entries are logged and skipped.
+    static std::vector<Interval> parseIntervals(std::string_view text);
+
+    /// history: completed bars kept per symbol and interval (at least 1).
+    /// The boundary timer runs on ioc.
+    BarAggregator(boost::asio::io_context& ioc, std::vector<Interval> intervals,
+                  std::size_t history, Sink sink);
+
+    /// Begin closing bars on interval boundaries.
+    void start();
+
+    /// Stop the timer.
+    void stop();
+
+    /// Fold in an L1 update if it reports a trade. Safe from any thread.
+    void apply(const DecodedMessage& msg);
+
+    /// Visit up to `count` most recent completed bars of every series,
+    /// oldest first. They are copied under the lock and visited after it is
+    /// released. seq receives the last BARS sequence number before the
+    /// visitor runs.
+    void snapshot(std::size_t count, const BarVisitor& onBar, std::uint64_t& seq) const;
+
+    const std::vector<Interval>& intervals() const { return intervals_; }
+
+    /// Write {"feed":"BARS","symbol":...,"interval":"1m",...} for one bar.
+    static void writeBar(rapidjson::Writer<rapidjson::StringBuffer>& w,
+                         std::string_view symbol, const Interval& interval,
+                         const Bar& bar, std::uint64_t seq, bool snapshot = false);
+
+private:
+    /// One symbol at one interval.
+    struct Series {
+        Bar           current;     ///< open bar; trades == 0 when there is none
+        std::uint32_t head{0};     ///< ring slot the next completed bar goes to
+        std::uint32_t count{0};    ///< completed bars in the ring
+    };
+
+    static constexpr std::int64_t kNever = std::numeric_limits<std::int64_t>::max();
+
+    static std::int64_t nowNs();
+
+    void bind(const Schema& l1);
+    void grow(SymbolId symbol);
+    void addTrade(SymbolId symbol, std::int64_t price, std::int64_t size, std::int64_t now);
+
+    /// Complete every open bar whose interval ended by now.
+    void advance(std::int64_t now);
+    void close(SymbolId symbol, std::size_t interval);
+    void schedule();
+
+    Series& series(SymbolId symbol, std::size_t interval) {
+        return series_[symbol * intervals_.size() + interval];
+    }
+    Bar* ring(SymbolId symbol, std::size_t interval) {
+        return &ring_[(symbol * intervals_.size() + interval) * history_];
+    }
+    const Bar* ring(SymbolId symbol, std::size_t interval) const {
+        return &ring_[(symbol * intervals_.size() + interval) * history_];
+    }
+
+    boost::asio::system_timer               timer_;
+    std::vector<Interval>                   intervals_;
+    std::size_t                             history_;
+    Sink                                    sink_;
+    bool                                    stopped_{false};
+
+    mutable std::mutex                      mutex_;
+    const Schema*                           schema_{nullptr};
+    int priceIdx_, sizeIdx_, totalIdx_, contentsIdx_;
+    std::vector<Series>                     series_;       ///< [symbol * intervals + i]
+    std::vector<Bar>                        ring_;         ///< [(symbol * intervals + i) * history + slot]
+    std::vector<std::int64_t>               totalVolume_;  ///< last Total Volume per symbol, -1 = none
+    std::vector<std::vector<SymbolId>>      open_;         ///< per interval: symbols with an open bar
+    std::vector<std::int64_t>               nextClose_;    ///< per interval: earliest open bar end
+    std::uint64_t                           seq_{0};
+};
@@ -0,0 +1,47 @@
+// File: include/BinaryEncoder.h
+#pragma once
+
+#include "MessageDecoder.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Compact tagged binary encoding of decoded feed rows, for clients that
+/// would rather not parse JSON. All integers are little-endian.
+///
+///   u8  version           kVersion
+///   u8  feed              id announced in the schema description
+///   u8  messageType       first character of the type code
+///   u8  flags             bit 0 = snapshot record
+///   u64 seq
+///   i64 timestamp         ns since the Unix epoch (0 = none)
+///   then per non-blank column:
+///     u8 head             (kind << 6) | column index
+///     value               kind 0: varint length + bytes
+///                         kind 1: zigzag varint int64
+///                         kind 2: zigzag varint, decimal scaled
+///                                 by 10^decimalDigits (exact)
+///
+/// Blank columns are omitted; the column layout comes from the schema.
+/// The Date/Time columns are omitted when carried by the timestamp, and
+/// the "Message Type" column is carried in the header instead.
+class BinaryEncoder {
+public:
+    static constexpr std::uint8_t kVersion = 2;
+
+    /// One feed's layout for describe().
+    struct FeedLayout {
+        const char*   name;
+        std::uint8_t  id;
+        const Schema* schema;
+    };
+
+    /// Encode one record into out, replacing its contents.
+    static void encode(const DecodedMessage& msg, std::uint8_t feedId,
+                       char messageType, std::uint64_t seq, bool snapshot,
+                       std::string& out);
+
+    /// JSON text message describing the column layout of each feed, sent
+    /// to a client when it switches to binary.
+    static std::string describe(const std::vector<FeedLayout>& feeds);
+};
@@ -0,0 +1,63 @@
+// File: include/ConfigWatcher.h
+#pragma once
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+/// Calls a handler when a watched file changes on disk.
+///
+/// Polls modification time and size on a timer, which works the same on
+/// Windows and Linux and is plenty for hand-edited config files. A change
+/// is reported once the file has looked the same for two polls in a row,
+/// so a handler never sees a half-written file. Handlers run on the
+/// io_context given to the constructor.
+class ConfigWatcher {
+public:
+    using Handler = std::function<void()>;
+
+    ConfigWatcher(boost::asio::io_context& ioc,
+                  std::chrono::milliseconds interval);
+
+    /// Watch path; call before start().
+    void watch(const std::filesystem::path& path, Handler onChange);
+
+    /// Begin polling.
+    void start();
+
+    /// Stop polling.
+    void stop();
+
+private:
+    /// What a file looked like at one poll.
+    struct Stamp {
+        std::filesystem::file_time_type mtime{};
+        std::uintmax_t                  size{0};
+        bool                            exists{false};
+
+        bool operator==(const Stamp& o) const {
+            return exists == o.exists && mtime == o.mtime && size == o.size;
+        }
+        bool operator!=(const Stamp& o) const { return !(*this == o); }
+    };
+
+    struct Entry {
+        std::filesystem::path path;
+        Handler               onChange;
+        Stamp                 seen;       ///< as last reported
+        Stamp                 pending;    ///< changed, waiting to settle
+        bool                  changing{false};
+    };
+
+    static Stamp stamp(const std::filesystem::path& path);
+    void schedule();
+    void poll();
+
+    boost::asio::steady_timer  timer_;
+    std::chrono::milliseconds  interval_;
+    std::vector<Entry>         entries_;
+    bool                       stopped_{false};
+};
@@ -1,15 +1,24 @@
 // File: include/ConnectionManager.h
 #pragma once
 
+#include "FeedJournal.h"
+#include "Metrics.h"
 #include <boost/asio.hpp>
 #include <functional>
 #include <string>
+#include <string_view>
+#include <vector>
 
 /// Connects to DTN localhost, reads CSV lines, lets you send commands,
 /// and notifies you on connect & per‐line.
+///
+/// Reads are done in large chunks into a reusable buffer; complete lines
+/// are framed in place and handed out as string_views that are valid only
+/// for the duration of the handler call.
 class ConnectionManager {
 public:
-    using MessageHandler = std::function<void(const std::string&)>;
+    using MessageHandler = std::function<void(std::string_view)>;
+    using BatchHandler   = std::function<void(const std::vector<std::string_view>&)>;
     using ConnectHandler = std::function<void()>;
 
     ConnectionManager(boost::asio::io_context& ioc,
@@ -19,31 +28,67 @@ public:
     /// Called once, after TCP connect succeeds.
     void setConnectHandler(ConnectHandler h);
 
+    /// Called when an established connection is lost, before the
+    /// reconnect is scheduled.
+    void setDisconnectHandler(ConnectHandler h);
+
     /// Called for every full CSV line read.
     void setMessageHandler(MessageHandler h);
 
+    /// Called once per socket read with every complete line it produced.
+    /// Takes precedence over the per-line handler.
+    void setBatchHandler(BatchHandler h);
+
+    /// Record every line read to journal (nullptr to stop). Lines are
+    /// captured before any handler sees them.
+    void setJournal(JournalWriter* journal, JournalChannel channel);
+
     /// Start connect/read loop.
     void start();
 
     /// Stop and close socket.
     void stop();
 
-    /// Send a command string (e.g. "WOR,MSFT\r\n") to the feed.
+    /// Queue a command string (e.g. "WOR,MSFT\r\n") for the feed. Safe
+    /// from any thread; never blocks. Commands queued together go out in
+    /// one write. Anything still queued when the connection drops is
+    /// discarded, since it was meant for the old session.
     void send(const std::string& cmd);
 
 private:
     void doConnect();
     void onConnect(const boost::system::error_code& ec);
-    void doReadLine();
-    void onReadLine(const boost::system::error_code& ec,
-                    std::size_t bytes_transferred);
+    void scheduleReconnect();
+    void doWrite();
+    void doRead();
+    void onRead(const boost::system::error_code& ec,
+                std::size_t bytes_transferred);
 
     boost::asio::io_context&     ioc_;
     boost::asio::ip::tcp::socket socket_;
+    boost::asio::steady_timer    retryTimer_;
     std::string                  host_;
     unsigned short               port_;
-    boost::asio::streambuf       buffer_;
+    std::vector<char>            buffer_;    ///< read buffer, [head_, tail_) unconsumed
+    std::size_t                  head_{0};
+    std::size_t                  tail_{0};
+    std::vector<std::string_view> batch_;    ///< lines framed by the last read
+    std::string                  outbox_;    ///< commands waiting for the socket
+    std::string                  inflight_;  ///< commands being written
     ConnectHandler               onConnect_;
+    ConnectHandler               onDisconnect_;
     MessageHandler               onMessage_;
+    BatchHandler                 onBatch_;
+    JournalWriter*               journal_{nullptr};
+    JournalChannel               channel_{JournalChannel::Admin};
     bool                         stopped_{false};
+    bool                         connected_{false};
+    bool                         writing_{false};
+
+    // Labelled endpoint="host:port"; owned by the Metrics registry.
+    Counter&                     connects_;
+    Counter&                     readErrors_;
+    Counter&                     lines_;
+    Counter&                     bytes_;
+    Histogram&                   batchLatency_;   ///< framing + handlers per read
 };
@@ -0,0 +1,29 @@
+// File: include/Deflate.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// Compresses whole messages into self-contained frames for clients that
+/// opted in to compression:
+///
+///   u8  kMarker
+///   u8  kind          0 = the message was text (JSON), 1 = binary
+///   raw deflate       RFC 1951, no zlib/gzip header, one stream per frame
+///
+/// No state carries over between frames, so one compressed frame can be
+/// sent unchanged to every client that asked for compression.
+class Deflate {
+public:
+    /// First byte of a compressed frame; never a record version or a
+    /// batch marker.
+    static constexpr std::uint8_t kMarker = 0xDF;
+
+    /// Compress payload into out at zlib level (1-9, or -1 for zlib's
+    /// default), replacing out's contents. Uses a stream kept per thread.
+    /// Returns false, leaving out unspecified, if zlib fails or the frame
+    /// would not be smaller than the payload.
+    static bool compress(std::string_view payload, bool binary, int level,
+                         std::string& out);
+};
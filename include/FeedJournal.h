@@ -0,0 +1,87 @@
+// File: include/FeedJournal.h
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Which connection a journaled line arrived on.
+enum class JournalChannel : std::uint8_t {
+    Admin = 0,
+    L1    = 1,
+    L2    = 2
+};
+
+/// Journal file layout (little-endian, unaligned):
+///
+///   file header   "DTNJRNL1"
+///   record        u64 receive time (ns since epoch)
+///                 u32 line length
+///                 u8  channel
+///                 line bytes (no line terminator)
+///
+/// The file is grown in large steps while writing and truncated to the
+/// last record on close; a zero length-and-time record also ends it.
+namespace FeedJournalFormat {
+    constexpr char        kMagic[8]    = {'D','T','N','J','R','N','L','1'};
+    constexpr std::size_t kRecordHeader = 8 + 4 + 1;
+}
+
+/// Appends raw feed lines to a memory-mapped journal. Safe to share
+/// between feed threads; each batch takes the lock once.
+class JournalWriter {
+public:
+    /// Create (or overwrite) the journal at path. Throws on I/O errors.
+    explicit JournalWriter(const std::string& path,
+                           std::size_t growBytes = 64u << 20);
+    ~JournalWriter();
+
+    JournalWriter(const JournalWriter&)            = delete;
+    JournalWriter& operator=(const JournalWriter&) = delete;
+
+    /// Record every line of one read, stamped with the current time.
+    void append(JournalChannel channel, const std::vector<std::string_view>& lines);
+
+    /// Truncate to the data written and unmap. Called by the destructor.
+    void close();
+
+    /// Bytes of records written so far, header included.
+    std::size_t size() const { return used_; }
+
+private:
+    /// Remap with room for at least `need` more bytes.
+    void grow(std::size_t need);
+
+    std::string                           path_;
+    std::size_t                           growBytes_;
+    std::size_t                           capacity_{0};
+    std::size_t                           used_{0};
+    boost::interprocess::file_mapping     file_;
+    boost::interprocess::mapped_region    region_;
+    std::mutex                            mutex_;
+    bool                                  open_{false};
+};
+
+/// Reads a journal back, optionally at its original pacing.
+class JournalReader {
+public:
+    using Handler = std::function<void(JournalChannel, std::string_view)>;
+
+    /// Map the journal at path read-only. Throws if it is missing or not
+    /// a journal.
+    explicit JournalReader(const std::string& path);
+
+    /// Feed every record to handler in order. speed 1.0 keeps the original
+    /// gaps between records, 2.0 halves them, and 0 replays as fast as
+    /// possible. Returns the number of records replayed.
+    std::size_t replay(const Handler& handler, double speed = 0.0) const;
+
+private:
+    boost::interprocess::file_mapping  file_;
+    boost::interprocess::mapped_region region_;
+};
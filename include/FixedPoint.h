@@ -0,0 +1,27 @@
+// File: include/FixedPoint.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// Exact decimal numbers as int64 in units of 1 / kScale. Prices are
+/// carried this way from the CSV text to the wire so they never pass
+/// through a binary double.
+class FixedPoint {
+public:
+    static constexpr int          kDigits = 8;
+    static constexpr std::int64_t kScale  = 100000000;   // 1e-8
+
+    /// Longest text format() produces, sign included.
+    static constexpr std::size_t  kMaxChars = 21;
+
+    /// Parse "[-+]digits[.digits]" into a scaled integer. Fractions longer
+    /// than kDigits are rounded half away from zero. Returns false on any
+    /// other syntax (exponents, blanks) or if the value does not fit.
+    static bool parse(std::string_view text, std::int64_t& out);
+
+    /// Write v as the shortest exact decimal ("157.25", "3", "-0.0001")
+    /// into out, which must hold kMaxChars. Returns the length.
+    static std::size_t format(std::int64_t v, char* out);
+};
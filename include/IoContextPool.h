@@ -0,0 +1,48 @@
+// File: include/IoContextPool.h
+#pragma once
+
+#include <boost/asio.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/// A fixed set of io_contexts, each driven by its own thread.
+/// Everything posted to one context runs on one thread, so objects pinned
+/// to a context need no further locking between their own handlers.
+class IoContextPool {
+public:
+    /// Create `size` contexts (at least one). Threads start in start().
+    explicit IoContextPool(std::size_t size);
+    ~IoContextPool();
+
+    IoContextPool(const IoContextPool&)            = delete;
+    IoContextPool& operator=(const IoContextPool&) = delete;
+
+    /// Number of contexts in the pool.
+    std::size_t size() const { return contexts_.size(); }
+
+    /// A specific context, for pinning long-lived objects.
+    boost::asio::io_context& at(std::size_t index);
+
+    /// Next context in round-robin order, for spreading short-lived objects.
+    boost::asio::io_context& next();
+
+    /// Launch one thread per context.
+    void start();
+
+    /// Release the work guards and stop every context.
+    void stop();
+
+    /// Block until every pool thread has exited.
+    void join();
+
+private:
+    using WorkGuard = boost::asio::executor_work_guard<
+        boost::asio::io_context::executor_type>;
+
+    std::vector<std::unique_ptr<boost::asio::io_context>> contexts_;
+    std::vector<WorkGuard>                                guards_;
+    std::vector<std::thread>                              threads_;
+    std::atomic<std::size_t>                              next_{0};
+};
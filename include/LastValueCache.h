@@ -0,0 +1,77 @@
+// File: include/LastValueCache.h
+#pragma once
+
+#include "MessageDecoder.h"
+#include "OrderBook.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Latest known state per symbol: the field-merged L1 record and the L2
+/// book. Every update is stamped with a per-stream sequence number under
+/// the same lock that snapshots take, so a snapshot's sequence number says
+/// exactly which live updates it already contains.
+///
+/// Records keep the schema they were decoded with. After an L1 schema
+/// reload a symbol's record starts afresh with its first update under
+/// the new schema.
+class LastValueCache {
+public:
+    explicit LastValueCache(const Schema& l2);
+
+    /// Merge an L1 update (non-blank fields overwrite). Returns its seq.
+    std::uint64_t updateL1(const DecodedMessage& msg);
+
+    /// Apply an L2 message to its book. Returns the changed book, or
+    /// nullptr; seq receives the BOOK sequence number of the change.
+    /// The returned book may be read (not modified) without the lock by
+    /// the calling feed thread: a symbol is only ever fed by one L2
+    /// connection, so that thread is the book's only writer.
+    OrderBook* applyL2(const DecodedMessage& msg, std::uint64_t& seq);
+
+    using L1Visitor    = std::function<void(const DecodedMessage&)>;
+    using BookVisitor  = std::function<void(SymbolId symbol, const OrderBook&)>;
+    using SymbolFilter = std::function<bool(SymbolId symbol)>;
+
+    /// Latest merged L1 record for one symbol. seq holds the caller's last
+    /// seen sequence number for the symbol on entry and the record's on
+    /// return; onL1 runs (under the lock) only if the record has changed
+    /// since. Returns false, with seq = 0, for an unknown symbol.
+    bool latestL1(SymbolId symbol, std::uint64_t& seq,
+                  const L1Visitor& onL1) const;
+
+    /// Visit the cached records and books the filters accept, each book cut
+    /// to its top bookDepth levels. They are copied under the cache locks and
+    /// visited after the locks are released, so serializing a snapshot does
+    /// not hold up the feed threads. l1Seq and bookSeq receive the last
+    /// sequence number of each stream at the moment of the copy; they are
+    /// set before the visitors run.
+    void snapshot(const SymbolFilter& wantL1, const SymbolFilter& wantBook,
+                  std::size_t bookDepth,
+                  const L1Visitor& onL1, const BookVisitor& onBook,
+                  std::uint64_t& l1Seq, std::uint64_t& bookSeq) const;
+
+private:
+    /// Owned copy of a decoded record; text is rebuilt into views on read.
+    struct L1Record {
+        std::array<std::string, Schema::kMaxFields>  text;
+        std::array<DecodedField, Schema::kMaxFields> value;
+        std::uint64_t                                seq{0};   ///< last update, 0 = none yet
+        const Schema*                                schema{nullptr};
+    };
+
+    /// Point view's fields at the record's owned copies.
+    void view(SymbolId symbol, const L1Record& rec, DecodedMessage& view) const;
+
+    mutable std::mutex                         l1Mutex_;
+    std::vector<L1Record>                      l1Records_;   ///< indexed by SymbolId
+    std::uint64_t                              l1Seq_{0};
+
+    mutable std::mutex                         bookMutex_;
+    OrderBookManager                           books_;
+    std::uint64_t                              bookSeq_{0};
+};
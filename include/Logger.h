@@ -0,0 +1,116 @@
+// File: include/Logger.h
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+enum class LogLevel : std::uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warn,
+    Error,
+    Off
+};
+
+/// Asynchronous logger. Callers format into a fixed stack buffer and push
+/// a binary record (time, level, bytes) onto a lock-free ring; a background
+/// thread turns records into text. Logging never blocks: when the ring is
+/// full the record is dropped and counted.
+///
+/// Until start() is called, and after stop(), lines are written directly.
+class Logger {
+public:
+    /// Longest message kept; longer ones are truncated.
+    static constexpr std::size_t kMaxMessage = 240;
+
+    /// Start the writer thread with a ring of `capacity` records
+    /// (rounded up to a power of two).
+    static void start(std::size_t capacity = 16384);
+
+    /// Drain the ring and join the writer thread.
+    static void stop();
+
+    static void     setLevel(LogLevel level);
+    static LogLevel level() { return static_cast<LogLevel>(level_.load(std::memory_order_relaxed)); }
+    static bool     enabled(LogLevel lvl) { return lvl >= level(); }
+
+    /// "trace" / "debug" / "info" / "warn" / "error" / "off"; unknown → Info.
+    static LogLevel parseLevel(const std::string& name);
+
+    /// Records dropped because the ring was full.
+    static std::uint64_t dropped();
+
+    /// Log the concatenation of args (strings, chars, numbers).
+    template <typename... Args>
+    static void log(LogLevel lvl, const Args&... args) {
+        if (!enabled(lvl)) return;
+        Line line;
+        (line.append(args), ...);
+        write(lvl, std::string_view(line.buf, line.len));
+    }
+
+    template <typename... Args> static void trace(const Args&... a) { log(LogLevel::Trace, a...); }
+    template <typename... Args> static void debug(const Args&... a) { log(LogLevel::Debug, a...); }
+    template <typename... Args> static void info (const Args&... a) { log(LogLevel::Info,  a...); }
+    template <typename... Args> static void warn (const Args&... a) { log(LogLevel::Warn,  a...); }
+    template <typename... Args> static void error(const Args&... a) { log(LogLevel::Error, a...); }
+
+private:
+    /// Caller-side formatting buffer.
+    struct Line {
+        char        buf[kMaxMessage];
+        std::size_t len{0};
+
+        void append(std::string_view s) {
+            const std::size_t n = std::min(s.size(), kMaxMessage - len);
+            s.copy(buf + len, n);
+            len += n;
+        }
+        void append(const char* s)        { append(std::string_view(s)); }
+        void append(const std::string& s) { append(std::string_view(s)); }
+        void append(char c)               { if (len < kMaxMessage) buf[len++] = c; }
+        void append(bool b)               { append(b ? "true" : "false"); }
+
+        template <typename T>
+        std::enable_if_t<std::is_integral_v<T>> append(T v) {
+            auto [p, ec] = std::to_chars(buf + len, buf + kMaxMessage, v);
+            if (ec == std::errc()) len = p - buf;
+        }
+        template <typename T>
+        std::enable_if_t<std::is_floating_point_v<T>> append(T v) {
+            char tmp[32];
+            const int n = std::snprintf(tmp, sizeof tmp, "%g", static_cast<double>(v));
+            if (n > 0) append(std::string_view(tmp, static_cast<std::size_t>(n)));
+        }
+    };
+
+    /// Push one record, or write it directly when no writer is running.
+    static void write(LogLevel lvl, std::string_view msg);
+
+    static std::atomic<std::uint8_t> level_;
+};
+
+/// Lets through one call in every N; for per-message logging on hot paths.
+///     static LogSampler sample(1000);
+///     if (sample()) Logger::debug(...);
+class LogSampler {
+public:
+    /// everyN == 0 lets nothing through.
+    explicit LogSampler(std::uint64_t everyN) : every_(everyN) {}
+
+    bool operator()() {
+        return every_ != 0 &&
+               count_.fetch_add(1, std::memory_order_relaxed) % every_ == 0;
+    }
+
+private:
+    std::atomic<std::uint64_t> count_{0};
+    std::uint64_t              every_;
+};
@@ -1,17 +1,53 @@
 // File: include/MessageDecoder.h
 #pragma once
 
-#include <rapidjson/document.h>
-#include <string>
-#include <vector>
+#include "FixedPoint.h"
+#include "SchemaLoader.h"
+#include "SymbolTable.h"
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <array>
+#include <cstdint>
+#include <string_view>
 
-/// Parses CSV lines into properly-typed JSON.
-/// Converts known numeric fields, merges Date+Time into ISO timestamp.
+/// One decoded CSV column. `text` views into the source line; an empty
+/// view means the column was blank (JSON null).
+struct DecodedField {
+    std::string_view text;
+    std::int64_t     i{0};   ///< Integer value, or Decimal scaled by FixedPoint::kScale
+    FieldType        type{FieldType::String};   ///< type after parse fallback
+};
+
+/// Fixed-capacity, allocation-free result of decoding one CSV line.
+/// Views stay valid only as long as the source line does.
+struct DecodedMessage {
+    const Schema*                                 schema{nullptr};
+    std::array<DecodedField, Schema::kMaxFields>  fields;
+    std::string_view                              timestamp;   ///< ISO-8601, or empty
+    std::int64_t                                  timestampNs{0};   ///< ns since the Unix epoch, 0 = none
+    SymbolId                                      symbol{kNoSymbol};   ///< interned symbol column
+
+private:
+    friend class MessageDecoder;
+    char timestampBuf_[64];
+};
+
+/// Parses CSV lines into properly-typed fields.
+/// Converts known numeric fields (prices to fixed-point), merges Date+Time
+/// into an ISO timestamp and its epoch nanoseconds.
 class MessageDecoder {
 public:
-    /// Decode a CSV line (using keys) into a JSON doc.
+    /// Decode a CSV line against a compiled schema. Splits in place and
+    /// performs no heap allocation (beyond interning a never-seen symbol).
     /// Returns false on parse error.
-    static bool decode(const std::vector<std::string>& keys,
-                       const std::string& csvLine,
-                       rapidjson::Document& doc);
+    static bool decode(const Schema& schema,
+                       std::string_view csvLine,
+                       DecodedMessage& out);
+
+    /// Stream the message's columns as JSON object members, in schema
+    /// order, straight into an open object. Keys come pre-escaped from the
+    /// schema. Date/Time give way to "timestamp" when merged, and the
+    /// "Message Type" column is left to the caller's messageType tag.
+    static void writeFields(const DecodedMessage& msg,
+                            rapidjson::Writer<rapidjson::StringBuffer>& w);
 };
@@ -0,0 +1,161 @@
+// File: include/Metrics.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// Metric updates go to one of kShards cache-line-sized slots picked per
+/// thread, so feed and WebSocket threads never contend on a line. Reads
+/// (scrapes) sum the shards.
+namespace MetricsDetail {
+    constexpr std::size_t kShards = 16;
+
+    /// This thread's shard, assigned round-robin on first use.
+    std::size_t shard();
+
+    /// Index of the highest set bit; v must be non-zero.
+    inline int highestBit(std::uint64_t v) {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return static_cast<int>(idx);
+#elif defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(v);
+#else
+        int idx = 0;
+        while (v >>= 1) ++idx;
+        return idx;
+#endif
+    }
+}
+
+/// Monotonic count.
+class Counter {
+public:
+    void inc(std::uint64_t n = 1) {
+        cells_[MetricsDetail::shard()].v.fetch_add(n, std::memory_order_relaxed);
+    }
+    std::uint64_t value() const;
+
+private:
+    struct alignas(64) Cell { std::atomic<std::uint64_t> v{0}; };
+    std::array<Cell, MetricsDetail::kShards> cells_;
+};
+
+/// Value that can go up and down.
+class Gauge {
+public:
+    void set(std::int64_t v) { v_.store(v, std::memory_order_relaxed); }
+    void add(std::int64_t d) { v_.fetch_add(d, std::memory_order_relaxed); }
+    std::int64_t value() const { return v_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> v_{0};
+};
+
+/// Log-linear (HDR-style) latency histogram in nanoseconds: 16 buckets per
+/// power of two, so any recorded value is within ~6% of its bucket.
+/// Values above ~18 minutes land in the top bucket.
+class Histogram {
+public:
+    static constexpr int         kSubBits    = 4;
+    static constexpr int         kMaxExp     = 40;
+    static constexpr std::size_t kBuckets    = (kMaxExp - kSubBits + 2) << kSubBits;
+
+    void record(std::uint64_t ns) {
+        Shard& s = shards_[MetricsDetail::shard()];
+        s.buckets[index(ns)].fetch_add(1, std::memory_order_relaxed);
+        s.sum.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    /// This histogram on one call in every samplingInterval() per thread
+    /// shard, else nullptr; pass to ScopedTimer to time only a sample.
+    Histogram* sample() {
+        Shard& s = shards_[MetricsDetail::shard()];
+        const auto n = s.ticks.fetch_add(1, std::memory_order_relaxed);
+        return (n & (interval_.load(std::memory_order_relaxed) - 1)) == 0 ? this : nullptr;
+    }
+
+    /// Time 1 in n events (n rounded down to a power of two, minimum 1).
+    static void setSamplingInterval(std::uint32_t n);
+
+    struct Summary {
+        std::uint64_t count{0};
+        std::uint64_t sum{0};   ///< ns
+        std::uint64_t p50{0}, p90{0}, p99{0}, p999{0}, max{0};
+    };
+    Summary summarize() const;
+
+    static std::size_t index(std::uint64_t v) {
+        if (v < (1u << kSubBits)) return static_cast<std::size_t>(v);
+        int e = MetricsDetail::highestBit(v);
+        if (e > kMaxExp) return kBuckets - 1;
+        const auto sub = (v >> (e - kSubBits)) & ((1u << kSubBits) - 1);
+        return static_cast<std::size_t>((e - kSubBits + 1) << kSubBits) + sub;
+    }
+
+    /// Largest value that maps to bucket i.
+    static std::uint64_t upperBound(std::size_t i);
+
+private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<std::uint64_t>, kBuckets> buckets{};
+        std::atomic<std::uint64_t>                       sum{0};
+        std::atomic<std::uint32_t>                       ticks{0};
+    };
+
+    std::array<Shard, MetricsDetail::kShards> shards_;
+    static std::atomic<std::uint32_t>         interval_;
+};
+
+/// Records the time from construction to destruction into a histogram;
+/// does nothing when given nullptr (e.g. an unsampled Histogram::sample()).
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram* h)
+      : h_(h), start_(h ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {}
+    ~ScopedTimer() {
+        if (h_) {
+            h_->record(static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start_).count()));
+        }
+    }
+    ScopedTimer(const ScopedTimer&)            = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram*                            h_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/// Process-wide metric registry, rendered in Prometheus text format.
+/// Register at startup; the returned references stay valid for the life
+/// of the process. Registering the same name and labels twice returns the
+/// existing metric.
+class Metrics {
+public:
+    /// labels are Prometheus label pairs without braces, e.g. feed="L1".
+    static Counter&   counter  (const std::string& name, const std::string& help,
+                                const std::string& labels = {});
+    static Gauge&     gauge    (const std::string& name, const std::string& help,
+                                const std::string& labels = {});
+    /// Rendered as a summary in seconds (quantiles, _sum, _count).
+    static Histogram& histogram(const std::string& name, const std::string& help,
+                                const std::string& labels = {});
+
+    /// Extra output appended to every scrape, for values that are cheaper
+    /// to read on demand (per-session queue depth, logger drops).
+    using Collector = std::function<void(std::string& out)>;
+    static void addCollector(Collector c);
+
+    /// The whole registry in Prometheus text exposition format 0.0.4.
+    static std::string render();
+};
@@ -0,0 +1,27 @@
+// File: include/MetricsServer.h
+#pragma once
+
+#include <boost/asio.hpp>
+#include <string>
+
+/// Minimal Boost.Beast HTTP listener serving Metrics::render() on
+/// GET /metrics for Prometheus. One request per connection; anything
+/// else gets 404. Runs on the io_context it is given.
+class MetricsServer {
+public:
+    MetricsServer(boost::asio::io_context& ioc,
+                  const std::string& address,
+                  unsigned short port);
+
+    /// Begin accepting scrapes.
+    void start();
+
+    /// Port actually bound; useful when constructed with port 0.
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+
+private:
+    void doAccept();
+
+    boost::asio::io_context&       ioc_;
+    boost::asio::ip::tcp::acceptor acceptor_;
+};
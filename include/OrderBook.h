@@ -0,0 +1,136 @@
+// File: include/OrderBook.h
+#pragma once
+
+#include "MessageDecoder.h"
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Prices inside the book are the decoder's fixed-point values, integers
+/// in units of 1 / kPriceScale.
+constexpr std::int64_t kPriceScale = FixedPoint::kScale;
+
+/// Aggregated interest at one price.
+struct PriceLevel {
+    std::int64_t  price;    ///< scaled by kPriceScale
+    std::int64_t  size;
+    std::uint32_t orders;   ///< 0 when fed by price-level messages
+};
+
+/// One symbol's book: orders keyed by Order ID, aggregated into flat,
+/// sorted price ladders. Each ladder keeps its best price at the back so
+/// the busy top of book is touched without shifting the rest.
+class OrderBook {
+public:
+    enum class Side : std::uint8_t { Bid = 0, Ask = 1 };
+
+    /// A level whose size changed in the last batch of mutations.
+    struct LevelChange {
+        Side          side;
+        std::int64_t  price;
+        std::int64_t  size;     ///< 0 = level removed
+        std::uint32_t orders;
+        std::size_t   rank;     ///< distance from best when changed
+    };
+
+    // --- market-by-order -------------------------------------------------
+    void addOrder(std::uint64_t id, Side side, std::int64_t price, std::int64_t size);
+    /// Replace an order's side/price/size; adds it if unknown.
+    void modifyOrder(std::uint64_t id, Side side, std::int64_t price, std::int64_t size);
+    void removeOrder(std::uint64_t id);
+
+    // --- market-by-price -------------------------------------------------
+    void setLevel(Side side, std::int64_t price, std::int64_t size);
+    void removeLevel(Side side, std::int64_t price);
+
+    /// Drop every order and level.
+    void clear();
+
+    /// Number of price levels on a side.
+    std::size_t depth(Side side) const { return ladder(side).size(); }
+
+    /// Level `rank` places from the best price (0 = best).
+    const PriceLevel& level(Side side, std::size_t rank) const {
+        const auto& l = ladder(side);
+        return l[l.size() - 1 - rank];
+    }
+
+    /// Level changes since the last clearChanges().
+    const std::vector<LevelChange>& changes() const { return changes_; }
+    void clearChanges() { changes_.clear(); }
+
+    /// True if any change since clearChanges() touched the top `n` levels.
+    bool topChanged(std::size_t n) const;
+
+    /// Copy of the top `n` levels per side, without the orders or pending
+    /// changes; enough to write a snapshot from once a lock is released.
+    OrderBook top(std::size_t n) const;
+
+    /// Write {"feed":"BOOK","type":"snapshot",...} with the top `n` levels.
+    void writeSnapshot(rapidjson::Writer<rapidjson::StringBuffer>& w,
+                       std::string_view symbol, std::size_t n,
+                       std::string_view timestamp, std::uint64_t seq) const;
+
+    /// Write {"feed":"BOOK","type":"delta",...} with the pending changes.
+    void writeDelta(rapidjson::Writer<rapidjson::StringBuffer>& w,
+                    std::string_view symbol,
+                    std::string_view timestamp, std::uint64_t seq) const;
+
+private:
+    struct Order {
+        Side         side;
+        std::int64_t price;
+        std::int64_t size;
+    };
+
+    std::vector<PriceLevel>&       ladder(Side side)       { return side == Side::Bid ? bids_ : asks_; }
+    const std::vector<PriceLevel>& ladder(Side side) const { return side == Side::Bid ? bids_ : asks_; }
+
+    /// Apply a size/order-count delta to the level at price, creating or
+    /// erasing it as needed.
+    void adjust(Side side, std::int64_t price, std::int64_t dSize, std::int32_t dOrders);
+    void record(Side side, const PriceLevel& lvl, std::size_t rank);
+
+    std::unordered_map<std::uint64_t, Order> orders_;
+    std::vector<PriceLevel>                  bids_;   ///< ascending, best at back
+    std::vector<PriceLevel>                  asks_;   ///< descending, best at back
+    std::vector<LevelChange>                 changes_;
+};
+
+/// Routes decoded L2 depth messages to per-symbol books.
+class OrderBookManager {
+public:
+    /// Resolve the depth columns from the L2 schema. They are resolved
+    /// again whenever a message arrives decoded with a different
+    /// (reloaded) schema.
+    explicit OrderBookManager(const Schema& l2);
+
+    /// Apply one decoded L2 message. Returns the book it changed, or
+    /// nullptr if the message did not touch a book.
+    OrderBook* apply(const DecodedMessage& msg);
+
+    /// Book for a symbol, or nullptr if none has been built yet.
+    const OrderBook* find(SymbolId symbol) const {
+        return symbol < books_.size() ? books_[symbol].get() : nullptr;
+    }
+
+    /// Call f(symbol, book) for every book.
+    template <typename F>
+    void forEach(F&& f) const {
+        for (std::size_t id = 0; id < books_.size(); ++id) {
+            if (books_[id]) f(static_cast<SymbolId>(id), *books_[id]);
+        }
+    }
+
+private:
+    void bind(const Schema& l2);
+
+    const Schema* schema_{nullptr};
+    int typeIdx_, orderIdx_, sideIdx_, priceIdx_, sizeIdx_, levelSizeIdx_;
+    std::vector<std::unique_ptr<OrderBook>> books_;   ///< indexed by SymbolId
+};
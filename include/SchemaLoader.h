@@ -1,20 +1,71 @@
 // File: include/SchemaLoader.h
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <map>
 
+/// Value type a schema column decodes to.
+enum class FieldType : std::uint8_t {
+    String,
+    Integer,
+    Decimal     ///< exact fixed-point, see FixedPoint
+};
+
+/// A schema compiled once at load time: the field names plus a fixed
+/// field-index → type table, so decoding never looks names up per tick.
+struct Schema {
+    /// Upper bound on columns; lets decoders use fixed-size storage.
+    static constexpr std::size_t kMaxFields = 64;
+
+    std::vector<std::string> fields;
+    std::vector<FieldType>   types;
+    std::vector<std::string> jsonKeys;        ///< fields as quoted, escaped JSON strings
+    int                      dateIndex{-1};   ///< "Date" column, or -1
+    int                      timeIndex{-1};   ///< "Time" column, or -1
+    int                      symbolIndex{-1}; ///< "Symbol"/"SYMBOL" column, or -1
+    int                      messageTypeIndex{-1}; ///< "Message Type" column, or -1
+    std::uint64_t            dateTimeMask{0}; ///< bits of the Date and Time columns
+};
+
 /// Loads CSV header files into named schemas.
+///
+/// Reloading an id publishes a new Schema by swapping one atomic pointer;
+/// decoders load that pointer once per message and are never blocked.
+/// Superseded versions are kept, not freed, so a decoded message, cached
+/// record or book may keep pointing at the schema it was built with.
 class SchemaLoader {
 public:
-    /// Load a CSV header (single row) from filePath into schema "id".
+    /// Load a CSV header (single row) from filePath into schema "id",
+    /// replacing any earlier version. A header identical to the current
+    /// one is not republished. Returns false, keeping the current
+    /// version, if the file is unreadable or malformed.
     static bool load(const std::string& id, const std::string& filePath);
 
     /// Retrieve the field list for the named schema.
     static const std::vector<std::string>& fields(const std::string& id);
 
+    /// Retrieve the current compiled schema for the named id.
+    static const Schema& schema(const std::string& id);
+
+    /// The named schema's current-version pointer, for hot paths to load
+    /// (acquire) per message. The reference stays valid forever.
+    static const std::atomic<const Schema*>& current(const std::string& id);
+
 private:
-    /// Storage for all loaded schemas
-    static std::map<std::string, std::vector<std::string>> schemas_;
+    struct Slot {
+        std::atomic<const Schema*>           current{nullptr};
+        std::vector<std::unique_ptr<Schema>> versions;   ///< every version ever published
+    };
+
+    /// Build the type table and special-field positions for a field list.
+    static Schema compile(std::vector<std::string> fields);
+
+    /// Storage for all loaded schemas; map nodes never move.
+    static std::map<std::string, Slot> schemas_;
+    static std::mutex                  mutex_;
 };
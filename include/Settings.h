@@ -0,0 +1,28 @@
+// File: include/Settings.h
+#pragma once
+
+#include <string>
+#include <map>
+
+/// Loads runtime tunables from a two-column CSV file (key,value).
+/// Lines starting with '#' are comments. Missing keys fall back to the
+/// default passed by the caller.
+class Settings {
+public:
+    /// Load key,value rows from filePath. Returns false if unreadable.
+    static bool load(const std::string& filePath);
+
+    /// Look up a string value.
+    static std::string getString(const std::string& key,
+                                 const std::string& def);
+
+    /// Look up an integer value; malformed values yield def.
+    static long long getInt(const std::string& key, long long def);
+
+    /// Look up a boolean value ("1"/"true"/"yes"/"on").
+    static bool getBool(const std::string& key, bool def);
+
+private:
+    /// Storage for all loaded settings
+    static std::map<std::string, std::string> values_;
+};
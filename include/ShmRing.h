@@ -0,0 +1,134 @@
+// File: include/ShmRing.h
+#pragma once
+
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// Shared-memory ring layout (native endianness; writer and readers share
+/// a host):
+///
+///   Control       at offset 0
+///   schema text   kSchemaBytes at kSchemaOffset, guarded by schemaVersion
+///   data          capacity bytes (a power of two) at kDataOffset
+///
+/// Records start on 16-byte boundaries of the byte stream:
+///
+///   u64 index     0, 1, 2, ... per ring; a gap means the reader lost records
+///   u32 length    payload bytes, or kPad: skip to the end of the ring
+///   u32 reserved
+///   payload       one BinaryEncoder frame
+///
+/// The writer never waits for readers. It advances `reserve` before it
+/// overwrites anything and `commit` once a record is complete, so a reader
+/// that copies a record and then still finds `reserve` within one
+/// capacity of it knows the copy is intact.
+namespace ShmRingFormat {
+    constexpr std::uint64_t kMagic        = 0x31474E49524E5444ull;   // "DTNRING1"
+    constexpr std::size_t   kSchemaOffset = 256;
+    constexpr std::size_t   kSchemaBytes  = 64u << 10;
+    constexpr std::size_t   kDataOffset   = kSchemaOffset + kSchemaBytes;
+    constexpr std::size_t   kRecordHeader = 16;
+    constexpr std::uint32_t kPad          = 0xFFFFFFFFu;
+
+    struct Control {
+        std::uint64_t                            magic;
+        std::uint64_t                            capacity;
+        std::atomic<std::uint32_t>               closed;          ///< writer has gone away
+        alignas(64) std::atomic<std::uint64_t>   reserve;         ///< stream end the writer may be touching
+        alignas(64) std::atomic<std::uint64_t>   commit;          ///< end of the last complete record
+        alignas(64) std::atomic<std::uint32_t>   schemaVersion;   ///< odd while the schema is rewritten
+        std::uint32_t                            schemaLength;
+    };
+    static_assert(sizeof(Control) <= kSchemaOffset, "control block overlaps schema");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                  "ring counters must be lock-free to be shared between processes");
+}
+
+/// Publishes records into a named shared-memory ring (/dev/shm/<name> on
+/// Linux). Exactly one thread may publish; any number of processes may
+/// read with ShmRingReader. Slow readers are overrun, never waited for.
+class ShmRingWriter {
+public:
+    /// Create (or replace) the ring. capacity is rounded up to a power of
+    /// two. Throws boost::interprocess::interprocess_exception on failure.
+    ShmRingWriter(const std::string& name, std::size_t capacity);
+    ~ShmRingWriter();
+
+    ShmRingWriter(const ShmRingWriter&)            = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    /// Append one record. Payloads over half the capacity are dropped.
+    void publish(std::string_view payload);
+
+    /// Replace the schema description readers decode payloads against.
+    /// May be called from another thread than publish(), but not
+    /// concurrently with itself.
+    void setSchema(std::string_view json);
+
+    /// Records published so far.
+    std::uint64_t published() const { return index_; }
+
+    const std::string& name() const { return name_; }
+
+private:
+    std::string                                 name_;
+    boost::interprocess::shared_memory_object   shm_;
+    boost::interprocess::mapped_region          region_;
+    ShmRingFormat::Control*                     control_{nullptr};
+    char*                                       data_{nullptr};
+    std::uint64_t                               mask_{0};
+    std::uint64_t                               head_{0};    ///< writer's copy of commit
+    std::uint64_t                               index_{0};
+};
+
+/// Follows a ShmRingWriter from another thread or process, starting at
+/// the newest record. Each reader keeps its own position; nothing is
+/// written to the ring, so readers cannot slow the writer down.
+class ShmRingReader {
+public:
+    /// One record, valid until the next call to next().
+    struct Record {
+        std::uint8_t     feed{0};          ///< from the frame header
+        char             messageType{0};
+        std::uint64_t    seq{0};
+        std::int64_t     timestampNs{0};
+        std::string_view frame;            ///< the whole BinaryEncoder frame
+    };
+
+    /// Map an existing ring read-only. Throws if it is missing or not a
+    /// ring.
+    explicit ShmRingReader(const std::string& name);
+
+    /// Copy out the next record. Returns false when caught up. Never
+    /// blocks and makes no system call.
+    bool next(Record& out);
+
+    /// Records skipped because the writer lapped this reader.
+    std::uint64_t lost() const { return lost_; }
+
+    /// Current schema description (BinaryEncoder::describe JSON).
+    std::string schema() const;
+
+    /// Changes whenever the schema is replaced; compare against a saved
+    /// value to know when to call schema() again.
+    std::uint32_t schemaVersion() const;
+
+    /// True once the writer has shut down; reopen to follow a new one.
+    bool closed() const;
+
+private:
+    boost::interprocess::shared_memory_object   shm_;
+    boost::interprocess::mapped_region          region_;
+    const ShmRingFormat::Control*               control_{nullptr};
+    const char*                                 data_{nullptr};
+    std::uint64_t                               capacity_{0};
+    std::uint64_t                               pos_{0};
+    std::uint64_t                               nextIndex_{0};
+    bool                                        started_{false};
+    std::uint64_t                               lost_{0};
+    std::string                                 buf_;
+};
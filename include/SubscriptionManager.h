@@ -0,0 +1,90 @@
+// File: include/SubscriptionManager.h
+#pragma once
+
+#include "ConnectionManager.h"
+#include "Metrics.h"
+#include "SymbolTable.h"
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+/// Pacing for subscription commands sent to one feed.
+struct SubscriptionOptions {
+    std::size_t               batchSize{500};   ///< commands per write
+    std::chrono::milliseconds interval{100};    ///< pause between writes
+};
+
+/// Keeps one feed connection subscribed to a set of symbols.
+///
+/// Callers say which symbols they want; the manager turns changes into
+/// subscribe/unsubscribe commands, coalesces them into batches of
+/// batchSize per write and paces the batches by interval, so a universe
+/// of tens of thousands of symbols never floods DTN or stalls the feed
+/// thread. Per-symbol state survives reconnects: after the next
+/// "S,SERVER CONNECTED" every wanted symbol is re-sent, again in paced
+/// batches.
+///
+/// Lives on its connection's io_context; public methods may be called
+/// from any thread.
+class SubscriptionManager {
+public:
+    using Options = SubscriptionOptions;
+
+    /// Command text around the ticker, e.g. "w" / "r" for L1 watches or
+    /// "WOR," / "ROR," for L2 depth. "\r\n" is appended.
+    SubscriptionManager(boost::asio::io_context& ioc,
+                        ConnectionManager& conn,
+                        std::string feed,
+                        std::string subscribePrefix,
+                        std::string unsubscribePrefix,
+                        Options options = {});
+
+    /// Want updates for symbol. Also retries a symbol the server rejected.
+    void subscribe(SymbolId symbol);
+
+    /// Stop wanting updates for symbol.
+    void unsubscribe(SymbolId symbol);
+
+    /// The feed said "S,SERVER CONNECTED": start (re)subscribing.
+    void onConnected();
+
+    /// The connection dropped; nothing is active until onConnected().
+    void onDisconnected();
+
+    /// The server reported symbol as unknown; it is not retried on
+    /// reconnect unless subscribed again.
+    void onRejected(SymbolId symbol);
+
+private:
+    enum : std::uint8_t {
+        kWanted   = 1 << 0,   ///< caller wants it
+        kActive   = 1 << 1,   ///< subscribe sent on this connection
+        kQueued   = 1 << 2,   ///< in pending_
+        kRejected = 1 << 3    ///< server did not know it
+    };
+
+    void enqueue(SymbolId symbol);
+    void schedule();
+    void flush();
+    std::uint8_t& state(SymbolId symbol);
+
+    boost::asio::io_context&   ioc_;
+    ConnectionManager&         conn_;
+    std::string                subscribePrefix_;
+    std::string                unsubscribePrefix_;
+    Options                    options_;
+    boost::asio::steady_timer  timer_;
+    std::vector<std::uint8_t>  state_;      ///< by SymbolId
+    std::deque<SymbolId>       pending_;    ///< symbols whose command is not yet sent
+    std::string                batch_;      ///< scratch for one write
+    bool                       connected_{false};
+    bool                       scheduled_{false};
+
+    // Labelled feed="..."; owned by the Metrics registry.
+    Counter&                   commands_;
+    Gauge&                     active_;
+    Gauge&                     backlog_;
+};
@@ -0,0 +1,64 @@
+// File: include/SymbolTable.h
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// Dense id of an interned ticker. Ids start at 0 and never change, so
+/// per-symbol state can live in flat arrays indexed by id.
+using SymbolId = std::uint32_t;
+
+/// No symbol (blank column, or the table is full).
+constexpr SymbolId kNoSymbol = 0xFFFFFFFFu;
+
+/// Process-wide ticker ↔ id table. Seeded from config/symbols.csv and
+/// extended as new tickers appear on the feeds or in client subscriptions.
+///
+/// Decode interns each row's ticker once; everything downstream (cache,
+/// books, routing, conflation) then indexes by id. Lookups take a shared
+/// lock; name() is lock-free.
+class SymbolTable {
+public:
+    /// Most symbols the table will hold.
+    static constexpr std::size_t kCapacity = std::size_t{1} << 22;
+
+    /// Intern each non-blank line of filePath. Returns the distinct ids in
+    /// file order; empty if the file is unreadable.
+    static std::vector<SymbolId> load(const std::string& filePath);
+
+    /// Id for symbol, adding it if new. kNoSymbol for a blank symbol or
+    /// when the table is full.
+    static SymbolId intern(std::string_view symbol);
+
+    /// Id for symbol, or kNoSymbol if it has never been interned.
+    static SymbolId find(std::string_view symbol);
+
+    /// Ticker for an id returned by intern(); empty for kNoSymbol.
+    static std::string_view name(SymbolId id) {
+        if (id >= size()) return {};
+        return chunks_[id >> kChunkBits].load(std::memory_order_acquire)[id & kChunkMask];
+    }
+
+    /// Number of interned symbols; every id below this is valid.
+    static std::size_t size() { return size_.load(std::memory_order_acquire); }
+
+private:
+    static constexpr std::size_t kChunkBits = 12;
+    static constexpr std::size_t kChunkMask = (std::size_t{1} << kChunkBits) - 1;
+    static constexpr std::size_t kChunks    = kCapacity >> kChunkBits;
+
+    /// Names live in fixed-size chunks that never move, so readers can hold
+    /// views while writers append.
+    static std::array<std::atomic<std::string*>, kChunks>     chunks_;
+    static std::vector<std::unique_ptr<std::string[]>>         owned_;
+    static std::atomic<std::size_t>                            size_;
+    static std::unordered_map<std::string_view, SymbolId>     ids_;
+    static std::shared_mutex                                   mutex_;
+};
@@ -1,46 +1,421 @@
 // File: include/WebSocketServer.h
 #pragma once
 
+#include "IoContextPool.h"
+#include "Metrics.h"
+#include "SymbolTable.h"
 #include <boost/asio.hpp>
 #include <boost/beast.hpp>
+#include <array>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <set>
 #include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// What a session does when its outbound queue is full.
+enum class OverflowPolicy {
+    DropOldest,   ///< discard the oldest queued message
+    Conflate,     ///< replace the queued message with the same key
+    Disconnect    ///< close the lagging session
+};
+
+/// Per-session outbound limits applied by WebSocketServer.
+struct WebSocketOptions {
+    std::size_t    maxQueueDepth{4096};
+    OverflowPolicy overflowPolicy{OverflowPolicy::DropOldest};
+    /// L1 conflation for new sessions: -1 = off, 0 = flush whenever the
+    /// socket is writable, >0 = flush every this many milliseconds.
+    int            l1ConflationMs{-1};
+    /// Micro-batching for new sessions: -1 = off, 0 = coalesce whatever
+    /// queued up while the previous write was in flight, >0 = also hold
+    /// messages up to this many microseconds to fill a frame.
+    std::int64_t   batchWindowUs{-1};
+    /// A batch is written early once this many payload bytes are queued,
+    /// and a frame never grows past it (a lone larger message is sent whole).
+    std::size_t    batchBytes{64 * 1024};
+    /// Deflate-compressed delivery for new sessions (see Deflate).
+    bool           compress{false};
+    /// zlib level for compressed frames, 1-9 (-1 = zlib's default).
+    int            compressLevel{6};
+    /// Messages shorter than this go out uncompressed.
+    std::size_t    compressMinBytes{128};
+    /// Most symbol ids client subscriptions may add to the SymbolTable for
+    /// tickers no feed has sent yet. Every id grows per-symbol state, so
+    /// clients must not be able to create them without bound.
+    std::size_t    maxClientSymbols{10000};
+};
+
+/// Feeds a session can subscribe to. L1, BOOK and BARS are snapshotted
+/// for late joiners; None marks control messages that reach every session.
+enum class Feed : std::uint8_t {
+    None = 0,
+    L1,
+    L2,
+    Book,
+    Bars,
+    Count
+};
+
+constexpr std::size_t kFeedCount = static_cast<std::size_t>(Feed::Count);
+
+/// "L1" / "L2" / "BOOK" / "BARS" → Feed; anything else → Feed::None.
+Feed parseFeed(std::string_view name);
+
+/// Routing metadata carried with each broadcast.
+struct MessageTag {
+    Feed             feed{Feed::None};
+    SymbolId         symbol{kNoSymbol};
+    char             type{0};           ///< message type code, 0 = untyped
+    std::uint64_t    seq{0};            ///< position in the feed, 0 = unsequenced
+    std::size_t      conflationKey{0};  ///< stream being updated; 0 = never conflate
+};
+
+/// Conflation key for one symbol's stream on a feed. The feed is part of
+/// the key so an L1 quote never replaces a queued BOOK snapshot for the
+/// same symbol, or the other way round. Never 0 for a real feed.
+constexpr std::size_t conflationKey(Feed feed, SymbolId symbol) {
+    return (std::size_t{symbol} << 3) | static_cast<std::size_t>(feed);
+}
+static_assert(static_cast<std::size_t>(Feed::Count) <= 8, "feed must fit in three key bits");
+
+/// Encoding a session receives feed records in.
+enum class WireFormat : std::uint8_t {
+    Json,     ///< text frames (default)
+    Binary    ///< BinaryEncoder records in binary frames
+};
+
+/// Messages a new subscriber receives before any live data, plus the last
+/// sequence number of each feed they reflect.
+struct Snapshot {
+    struct Frame {
+        std::string data;
+        bool        binary{false};
+    };
+
+    WireFormat                             format{WireFormat::Json};   ///< what the session asked for
+    std::size_t                            barHistory{1};   ///< completed bars wanted per series
+    std::vector<Frame>                     messages;
+    std::array<std::uint64_t, kFeedCount>  seq{};
+};
 
 /// A simple Boost.Beast WebSocket server that broadcasts incoming messages.
+///
+/// Clients narrow what they receive with text commands:
+///   {"op":"subscribe","feed":"L1","symbols":["MSFT"],"types":["Q"]}
+///   {"op":"unsubscribe","feed":"L1","symbols":["MSFT"]}
+/// Omitting "feed", "symbols" or "types" means all. A BARS subscription may
+/// add "history":N to start from the last N completed bars of each series
+/// (default 1). A client that connects
+/// with "subscribe=none" in its URL query starts with no subscriptions;
+/// otherwise it starts subscribed to everything.
+///
+/// Records are JSON text unless the client negotiates binary, either with
+/// the "dtn.binary" WebSocket subprotocol or {"op":"format","value":"binary"}.
+///
+/// {"op":"conflate","value":true,"interval":50} switches a session's L1 to
+/// conflated delivery: updates only mark their symbol dirty, and each flush
+/// sends the latest merged record per dirty symbol. "interval" is in
+/// milliseconds; 0 or absent flushes whenever the socket is writable.
+///
+/// {"op":"batch","value":true,"window":1,"bytes":65536} coalesces queued
+/// messages into fewer frames: text frames become JSON arrays of messages,
+/// binary frames kBatchMarker followed by u32 little-endian length-prefixed
+/// records. A batch goes out once "window" milliseconds (fractions allowed;
+/// 0 = whenever the socket is free) have passed since its oldest message,
+/// or as soon as "bytes" are queued, whichever comes first.
+///
+/// {"op":"compress","value":true} switches a session to compressed frames
+/// (Deflate). Each message is compressed once, on the publishing thread,
+/// and the same bytes go to every compressed session, so CPU cost does not
+/// grow with the number of clients.
 class WebSocketServer {
 public:
-    WebSocketServer(boost::asio::io_context& ioc, unsigned short port);
+    /// Immutable, ref-counted payload shared by every session it is sent to.
+    using SharedMessage = std::shared_ptr<const std::string>;
+
+    using Options = WebSocketOptions;
+
+    /// First byte of a batched binary frame; never a record version.
+    static constexpr std::uint8_t kBatchMarker = 0xB7;
+
+    /// Which (feed, symbol) pairs a snapshot should cover.
+    using SnapshotFilter = std::function<bool(Feed, SymbolId symbol)>;
+
+    /// Fills a snapshot of current state for a new subscription.
+    using SnapshotProvider = std::function<void(const SnapshotFilter&, Snapshot&)>;
+
+    /// Renders the latest merged L1 record for symbol into out, unless its
+    /// seq still equals haveSeq. Returns the record's seq (0 = unknown).
+    using ConflationProvider = std::function<std::uint64_t(
+        SymbolId symbol, WireFormat format, std::uint64_t haveSeq, std::string& out)>;
+
+    /// Parse "drop-oldest" / "conflate" / "disconnect"; unknown → DropOldest.
+    static OverflowPolicy parsePolicy(const std::string& name);
+
+    /// Sessions are spread round-robin across the pool's contexts; each
+    /// session's handlers then run on a single thread.
+    WebSocketServer(IoContextPool& pool, unsigned short port,
+                    Options options = {});
+
+    /// Set the snapshot source for late joiners. Call before start().
+    void setSnapshotProvider(SnapshotProvider provider);
+
+    /// Set the source of conflated L1 records. Call before start();
+    /// without one, conflation requests are refused.
+    void setConflationProvider(ConflationProvider provider);
+
+    /// Text message sent to a client before its first binary record,
+    /// describing the binary layout. May be called again at any time (e.g.
+    /// after a schema reload); binary sessions are then sent the new one.
+    void setSchemaDescription(std::string description);
 
     /// Begin accepting clients
     void start();
 
-    /// Broadcast a text message to all connected sessions
-    void broadcast(const std::string& message);
+    /// Port actually bound; useful when constructed with port 0.
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+
+    /// True if any session would receive a message with this tag.
+    bool hasSubscribers(const MessageTag& tag);
+
+    /// Route a message to the sessions subscribed to its feed, symbol and
+    /// type. `produce` (returning std::string_view) is called at most once,
+    /// and only if someone is interested; its bytes are copied into one
+    /// shared buffer. Safe to call from any thread.
+    template <typename Produce>
+    void publish(const MessageTag& tag, Produce&& produce) {
+        auto& targets = collect(tag);
+        if (targets.list.empty() && targets.conflated.empty()) return;
+        SharedMessage text;
+        if (!targets.list.empty()) text = std::make_shared<const std::string>(produce());
+        deliver(targets, text, nullptr, tag);
+    }
+
+    /// As above, with a second producer for binary sessions. Each format is
+    /// encoded once, and only if some target session uses it.
+    template <typename ProduceJson, typename ProduceBinary>
+    void publish(const MessageTag& tag, ProduceJson&& json, ProduceBinary&& binary) {
+        auto& targets = collect(tag);
+        if (targets.list.empty() && targets.conflated.empty()) return;
+        SharedMessage text, bin;
+        if (targets.json)   text = std::make_shared<const std::string>(json());
+        if (targets.binary) bin  = std::make_shared<const std::string>(binary());
+        deliver(targets, text, bin, tag);
+    }
+
+    /// Broadcast a text message to all matching sessions. Safe to call
+    /// from any thread. The bytes are copied once into a shared buffer;
+    /// callers may reuse theirs at once.
+    /// Sequenced messages already covered by a session's snapshot are
+    /// skipped for that session.
+    void broadcast(std::string_view message, const MessageTag& tag = {});
+
+    /// Broadcast an already-shared payload without copying it.
+    void broadcast(const SharedMessage& message, const MessageTag& tag = {});
 
 private:
+    struct Session;
+
+    /// Sessions one message goes to, and which encodings they need.
+    struct Targets {
+        struct Target {
+            std::shared_ptr<Session> session;
+            WireFormat               format;
+            bool                     deflate;
+        };
+        std::vector<Target> list;
+        std::vector<std::shared_ptr<Session>> conflated;   ///< only marked dirty
+        bool                json{false};
+        bool                binary{false};
+    };
+
+    /// What one session wants from one feed. Guarded by sessionsMutex_.
+    struct Subscription {
+        bool                            all{false};   ///< every symbol
+        std::unordered_set<SymbolId>    symbols;
+        std::bitset<128>                types;        ///< accepted type codes
+    };
+
+    /// The per-message facts a session needs after the publish call returns.
+    struct Delivery {
+        Feed          feed;
+        std::uint64_t seq;
+        std::size_t   conflationKey;
+        SymbolId      symbol;
+    };
+
     struct Session : std::enable_shared_from_this<Session> {
         Session(boost::asio::ip::tcp::socket socket,
                 WebSocketServer& parent);
 
         void start();
-        void send(const std::string& msg);
+        void send(SharedMessage msg, const Delivery& d, bool binary);
+        /// Note a conflated L1 update for symbol; any thread.
+        void markDirty(SymbolId symbol);
+
+        std::array<Subscription, kFeedCount> subs;   ///< guarded by parent's sessionsMutex_
+        WireFormat format{WireFormat::Json};          ///< written under sessionsMutex_
+        bool conflate{false};                         ///< written under sessionsMutex_
+        bool compress{false};                         ///< written under sessionsMutex_
+        const std::uint64_t      id;                  ///< for metrics labels
+        std::atomic<std::size_t> depth{0};            ///< queue_.size(), readable off-thread
 
     private:
+        struct Outbound {
+            SharedMessage payload;
+            std::size_t   key;
+            bool          binary;
+        };
+
+        void onRequest(boost::beast::error_code ec);
         void onAccept(boost::beast::error_code ec);
+        void doRead();
+        void onRead(boost::beast::error_code ec, std::size_t);
+        void handleCommand(std::string_view text);
+        void sendSnapshot(const SnapshotFilter& filter,
+                          const std::vector<std::pair<Feed, SymbolId>>& added,
+                          std::size_t barHistory = 1);
+        void reply(std::string msg);
+        void setFormat(WireFormat format);
+        void setConflation(int intervalMs);
+        void setCompression(bool on);
+        void armConflationTimer();
+        void flushDirty();
+        void enqueue(SharedMessage msg, const Delivery& d, bool binary);
+        void doWrite();
         void onWrite(boost::beast::error_code ec, std::size_t);
+        void close();
+        void noteDepth() { depth.store(queue_.size(), std::memory_order_relaxed); }
+        void push(Outbound out);
+        /// Start a write if the socket is free and the batch window allows.
+        void kick();
+        void setBatching(std::int64_t windowUs, std::size_t bytes);
+        void armBatchTimer();
 
         WebSocketServer&                          parent_;
         boost::beast::websocket::stream<
             boost::asio::ip::tcp::socket>        ws_;
-        std::mutex                                writeMutex_;
+        boost::beast::flat_buffer                 readBuffer_;
+        boost::beast::http::request<
+            boost::beast::http::string_body>     request_;
+        std::deque<Outbound>                      queue_;      ///< pending writes, front in flight unless batching
+        std::size_t                               queuedBytes_{0};   ///< payload bytes in queue_
+        /// Sequenced messages at or below these were covered by a snapshot.
+        std::array<std::uint64_t, kFeedCount>     floor_{};
+        std::array<std::unordered_map<SymbolId, std::uint64_t>,
+                   kFeedCount>                    symbolFloor_;
+        std::size_t                               dropped_{0};
+        boost::asio::steady_timer                 conflateTimer_;
+        std::atomic<int>                          conflateMs_{-1};   ///< as in Options
+        std::mutex                                dirtyMutex_;
+        std::vector<SymbolId>                     dirty_;      ///< guarded by dirtyMutex_
+        std::vector<bool>                         isDirty_;    ///< by SymbolId, guarded by dirtyMutex_
+        std::vector<SymbolId>                     flushing_;   ///< scratch for flushDirty
+        boost::asio::steady_timer                 batchTimer_;
+        std::int64_t                              batchUs_{-1};      ///< as in Options
+        std::size_t                               batchBytes_{0};
+        std::chrono::steady_clock::time_point     batchDeadline_;    ///< when the oldest queued message is due
+        std::string                               batch_;            ///< frame being written
+        std::size_t                               batchCount_{0};    ///< messages in batch_
+        bool                                      batchArmed_{false};
+        bool                                      batchWriting_{false};   ///< in-flight write is batch_
+        bool                                      open_{false};
+        bool                                      writing_{false};
+        bool                                      closed_{false};
     };
 
     void doAccept();
+    void join(const std::shared_ptr<Session>& session, bool subscribeAll);
+    void leave(const std::shared_ptr<Session>& session);
 
-    boost::asio::io_context&                   ioc_;
+    /// Add or remove subscriptions (empty symbols = whole feed); returns
+    /// the (feed, symbol) pairs newly added, with kNoSymbol meaning the
+    /// whole feed.
+    std::vector<std::pair<Feed, SymbolId>>
+    updateSubscription(const std::shared_ptr<Session>& session, bool add,
+                       const std::vector<Feed>& feeds,
+                       const std::vector<SymbolId>& symbols,
+                       const std::string& types);
+
+    void setFormat(const std::shared_ptr<Session>& session, WireFormat format);
+    SharedMessage schemaDescription();
+    void setConflation(const std::shared_ptr<Session>& session, bool on);
+    void setCompression(const std::shared_ptr<Session>& session, bool on);
+
+    /// Id for a ticker named in a client subscription, interning it only
+    /// while the maxClientSymbols budget lasts. kNoSymbol if refused.
+    SymbolId clientSymbol(std::string_view name);
+
+    /// msg as a compressed frame, or null if it is too short or would not
+    /// shrink.
+    SharedMessage compressed(const std::string& msg, bool binary);
+
+    /// Latest merged L1 record for symbol in format (compressed if deflate
+    /// and worthwhile), rendered at most once per update however many
+    /// sessions flush it. Null if unknown. binaryFrame receives whether
+    /// the result goes out as a binary frame.
+    SharedMessage conflatedL1(SymbolId symbol, WireFormat format, bool deflate,
+                              std::uint64_t& seq, bool& binaryFrame);
+
+    /// Per-session queue depth series for a metrics scrape.
+    void renderSessionMetrics(std::string& out);
+
+    void indexAdd(Session* s, Feed feed, SymbolId symbol);
+    void indexRemove(Session* s, Feed feed, SymbolId symbol);
+
+    /// Sessions interested in tag, gathered into thread-local scratch.
+    Targets& collect(const MessageTag& tag);
+    /// Send text to JSON sessions and binary (or text, if null) to binary ones.
+    void deliver(Targets& targets, const SharedMessage& text,
+                 const SharedMessage& binary, const MessageTag& tag);
+
+    /// Routing index for one feed: whole-feed subscribers plus per-symbol
+    /// subscribers indexed by SymbolId, so a tick only visits interested
+    /// sessions.
+    struct Route {
+        std::vector<Session*>               all;
+        std::vector<std::vector<Session*>>  bySymbol;
+    };
+
+    IoContextPool&                             pool_;
     boost::asio::ip::tcp::acceptor             acceptor_;
+    Options                                    options_;
+    SnapshotProvider                           snapshotProvider_;
+    ConflationProvider                         conflationProvider_;
+    SharedMessage                              schemaDescription_;   ///< guarded by sessionsMutex_
     std::set<std::shared_ptr<Session>>         sessions_;
+    std::array<Route, kFeedCount>              routes_;
     std::mutex                                 sessionsMutex_;
+    std::atomic<std::uint64_t>                 nextSessionId_{1};
+    std::atomic<std::size_t>                   clientSymbols_{0};   ///< ids interned for clients
+
+    /// Last rendering of each symbol's merged L1 record, per WireFormat,
+    /// then compressed per WireFormat.
+    struct Rendered {
+        std::uint64_t seq{0};
+        SharedMessage message;
+    };
+    std::vector<std::array<Rendered, 4>>       conflated_;   ///< indexed by SymbolId
+    std::mutex                                 conflatedMutex_;
+
+    // Owned by the Metrics registry.
+    Gauge&                                     sessionsOpen_;
+    Counter&                                   messagesSent_;
+    Counter&                                   bytesSent_;
+    Counter&                                   overflowDrops_;
+    Counter&                                   slowDisconnects_;
+    Counter&                                   batchedMessages_;
+    Counter&                                   deflateIn_;
+    Counter&                                   deflateOut_;
+    Histogram&                                 fanoutLatency_;
 };
@@ -1,7 +1,8 @@
 // File: src/AuthManager.cpp
 #include "AuthManager.h"
+#include "Logger.h"
 #include <fstream>
-#include <iostream>
+#include <istream>
 
 bool AuthManager::authenticate(boost::asio::io_context& ioc,
                                const std::string& host,
@@ -11,8 +12,8 @@ bool AuthManager::authenticate(boost::asio::io_context& ioc,
     // 1) Load credentials
     std::ifstream in(credFile);
     if (!in.is_open()) {
-        std::cerr << "AuthManager: cannot open credentials file: "
-                  << credFile << "\n";
+        Logger::error("AuthManager: cannot open credentials file: ",
+                      credFile);
         return false;
     }
     std::string line;
@@ -21,7 +22,7 @@ bool AuthManager::authenticate(boost::asio::io_context& ioc,
 
     auto commaPos = line.find(',');
     if (commaPos == std::string::npos) {
-        std::cerr << "AuthManager: invalid credentials format\n";
+        Logger::error("AuthManager: invalid credentials format");
         return false;
     }
     std::string user = line.substr(0, commaPos);
@@ -46,15 +47,15 @@ bool AuthManager::authenticate(boost::asio::io_context& ioc,
         std::getline(is, respLine);
 
         if (respLine == "OK") {
-            std::cout << "AuthManager: authenticated successfully\n";
+            Logger::info("AuthManager: authenticated successfully");
             return true;
         } else {
-            std::cerr << "AuthManager: auth failed: "
-                      << respLine << "\n";
+            Logger::error("AuthManager: auth failed: ",
+                          respLine);
             return false;
         }
     } catch (const std::exception& e) {
-        std::cerr << "AuthManager: exception: " << e.what() << "\n";
+        Logger::error("AuthManager: exception: ", e.what());
         return false;
     }
 }
@@ -0,0 +1,300 @@
+// File: src/BarAggregator.cpp
+#include "BarAggregator.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Prices go out as exact decimal numbers, as in OrderBook.
+static void writePrice(rapidjson::Writer<rapidjson::StringBuffer>& w, std::int64_t price)
+{
+    char buf[FixedPoint::kMaxChars];
+    w.RawValue(buf, FixedPoint::format(price, buf), rapidjson::kNumberType);
+}
+
+static int columnOf(const Schema& schema, const char* name)
+{
+    for (std::size_t idx = 0; idx < schema.fields.size(); ++idx) {
+        if (schema.fields[idx] == name) return static_cast<int>(idx);
+    }
+    return -1;
+}
+
+// "2026-10-17T14:30:00Z", with milliseconds when not on a whole second.
+static std::size_t formatUtc(std::int64_t ns, char* out, std::size_t size)
+{
+    constexpr std::int64_t kNsPerSec = 1000000000;
+    std::int64_t secs = ns / kNsPerSec;
+    std::int64_t frac = ns % kNsPerSec;
+    if (frac < 0) { frac += kNsPerSec; --secs; }
+    std::int64_t days = secs / 86400;
+    std::int64_t sod  = secs % 86400;
+    if (sod < 0) { sod += 86400; --days; }
+
+    // days since 1970-01-01 → civil date (proleptic Gregorian)
+    days += 719468;
+    const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const std::int64_t doe = days - era * 146097;
+    const std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const std::int64_t mp  = (5 * doy + 2) / 153;
+    const int day   = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+    const int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    const long long year = yoe + era * 400 + (month <= 2);
+
+    const int n = frac / 1000000
+        ? std::snprintf(out, size, "%04lld-%02d-%02dT%02d:%02d:%02d.%03dZ", year, month, day,
+                        int(sod / 3600), int(sod / 60 % 60), int(sod % 60), int(frac / 1000000))
+        : std::snprintf(out, size, "%04lld-%02d-%02dT%02d:%02d:%02dZ", year, month, day,
+                        int(sod / 3600), int(sod / 60 % 60), int(sod % 60));
+    return n > 0 ? std::min(static_cast<std::size_t>(n), size - 1) : 0;
+}
+
+// — Bar —
+
+std::int64_t Bar::vwap() const {
+    return volume > 0 ? std::llround(notional / static_cast<double>(volume)) : 0;
+}
+
+// — BarAggregator —
+
+std::vector<BarAggregator::Interval> BarAggregator::parseIntervals(std::string_view text) {
+    std::vector<Interval> out;
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        const std::size_t end = std::min(text.find_first_of(", \t", pos), text.size());
+        const std::string_view token = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (token.empty()) continue;
+
+        std::size_t digits = 0;
+        std::int64_t n = 0;
+        while (digits < token.size() && digits < 9 &&
+               token[digits] >= '0' && token[digits] <= '9') {
+            n = n * 10 + (token[digits++] - '0');
+        }
+        const std::string_view unit = token.substr(digits);
+        std::int64_t unitNs = 0;
+        if      (unit == "ms") unitNs = 1000000;
+        else if (unit == "s")  unitNs = 1000000000;
+        else if (unit == "m")  unitNs = 60000000000;
+        else if (unit == "h")  unitNs = 3600000000000;
+        // Checked before multiplying; a week also keeps the boundary
+        // arithmetic around the current time far from overflow.
+        constexpr std::int64_t kMaxIntervalNs = 7 * 24 * 3600000000000;
+        if (unitNs != 0 && n > kMaxIntervalNs / unitNs) {
+            Logger::warn("Bars: ignoring interval '", token, "' (longer than a week)");
+            continue;
+        }
+        const std::int64_t ns = n * unitNs;
+        if (digits == 0 || ns <= 0) {
+            Logger::warn("Bars: ignoring interval '", token, "' (expected e.g. 500ms, 1s, 1m, 1h)");
+            continue;
+        }
+        const bool seen = std::any_of(out.begin(), out.end(),
+                                      [ns](const Interval& i) { return i.ns == ns; });
+        if (!seen) out.push_back({ns, std::string(token)});
+    }
+    return out;
+}
+
+BarAggregator::BarAggregator(boost::asio::io_context& ioc, std::vector<Interval> intervals,
+                             std::size_t history, Sink sink)
+  : timer_(ioc),
+    intervals_(std::move(intervals)),
+    history_(std::max<std::size_t>(1, history)),
+    sink_(std::move(sink)),
+    priceIdx_(-1), sizeIdx_(-1), totalIdx_(-1), contentsIdx_(-1),
+    open_(intervals_.size()),
+    nextClose_(intervals_.size(), kNever)
+{}
+
+void BarAggregator::start() {
+    schedule();
+}
+
+void BarAggregator::stop() {
+    stopped_ = true;
+    timer_.cancel();
+}
+
+std::int64_t BarAggregator::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void BarAggregator::bind(const Schema& l1) {
+    schema_      = &l1;
+    priceIdx_    = columnOf(l1, "Most Recent Trade");
+    sizeIdx_     = columnOf(l1, "Most Recent Trade Size");
+    totalIdx_    = columnOf(l1, "Total Volume");
+    contentsIdx_ = columnOf(l1, "Message Contents");
+}
+
+void BarAggregator::grow(SymbolId symbol) {
+    if (symbol < totalVolume_.size()) return;
+    const std::size_t n = std::size_t{symbol} + 1;
+    series_.resize(n * intervals_.size());
+    ring_.resize(n * intervals_.size() * history_);
+    totalVolume_.resize(n, -1);
+}
+
+void BarAggregator::apply(const DecodedMessage& msg) {
+    if (msg.symbol == kNoSymbol || !msg.schema || intervals_.empty()) return;
+    auto integer = [&](int idx) -> std::int64_t {
+        return (idx >= 0 && msg.fields[idx].type == FieldType::Integer)
+            ? msg.fields[idx].i : -1;
+    };
+
+    std::lock_guard lock(mutex_);
+    if (msg.schema != schema_) bind(*msg.schema);
+    if (priceIdx_ < 0) return;
+    grow(msg.symbol);
+
+    // Total Volume only rises during a session; a drop is a new session.
+    std::int64_t& lastTotal = totalVolume_[msg.symbol];
+    const std::int64_t total = integer(totalIdx_);
+    const std::int64_t rise  = (total > lastTotal && lastTotal >= 0) ? total - lastTotal : 0;
+    if (total >= 0) lastTotal = total;
+
+    const bool trade = contentsIdx_ >= 0
+        ? msg.fields[contentsIdx_].text.find_first_of("CE") != std::string_view::npos
+        : rise > 0;
+    const DecodedField& price = msg.fields[priceIdx_];
+    if (!trade || price.type != FieldType::Decimal) return;
+
+    std::int64_t size = integer(sizeIdx_);
+    if (size < 0) size = rise;
+    addTrade(msg.symbol, price.i, size, nowNs());
+}
+
+void BarAggregator::addTrade(SymbolId symbol, std::int64_t price, std::int64_t size,
+                             std::int64_t now) {
+    advance(now);
+    for (std::size_t i = 0; i < intervals_.size(); ++i) {
+        Bar& bar = series(symbol, i).current;
+        if (bar.trades == 0) {
+            const std::int64_t len = intervals_[i].ns;
+            bar = Bar{};
+            bar.startNs = now - now % len;
+            bar.open = bar.high = bar.low = price;
+            open_[i].push_back(symbol);
+            nextClose_[i] = std::min(nextClose_[i], bar.startNs + len);
+        }
+        // A clock step backwards lands in the open bar rather than reopening
+        // one that was already published.
+        bar.high      = std::max(bar.high, price);
+        bar.low       = std::min(bar.low, price);
+        bar.close     = price;
+        bar.volume   += size;
+        bar.notional += static_cast<double>(price) * static_cast<double>(size);
+        ++bar.trades;
+    }
+}
+
+void BarAggregator::advance(std::int64_t now) {
+    for (std::size_t i = 0; i < intervals_.size(); ++i) {
+        if (now < nextClose_[i]) continue;
+        const std::int64_t len = intervals_[i].ns;
+        auto& open = open_[i];
+        std::int64_t next = kNever;
+        std::size_t keep = 0;
+        for (SymbolId symbol : open) {
+            const std::int64_t end = series(symbol, i).current.startNs + len;
+            if (end <= now) {
+                close(symbol, i);
+            } else {
+                open[keep++] = symbol;
+                next = std::min(next, end);
+            }
+        }
+        open.resize(keep);
+        nextClose_[i] = next;
+    }
+}
+
+void BarAggregator::close(SymbolId symbol, std::size_t interval) {
+    Series& s = series(symbol, interval);
+    Bar& slot = ring(symbol, interval)[s.head];
+    slot = s.current;
+    s.current = Bar{};
+    s.head = static_cast<std::uint32_t>((s.head + 1) % history_);
+    if (s.count < history_) ++s.count;
+    sink_(symbol, intervals_[interval], slot, ++seq_);
+}
+
+void BarAggregator::schedule() {
+    if (stopped_) return;
+    // Wake on the next boundary of any interval to close quiet symbols' bars.
+    const std::int64_t now = nowNs();
+    std::int64_t next = kNever;
+    for (const auto& interval : intervals_) {
+        next = std::min(next, (now / interval.ns + 1) * interval.ns);
+    }
+    if (next == kNever) return;
+    timer_.expires_at(std::chrono::system_clock::time_point(
+        std::chrono::ceil<std::chrono::system_clock::duration>(std::chrono::nanoseconds(next))));
+    timer_.async_wait([this](const boost::system::error_code& ec) {
+        if (ec) return;
+        {
+            std::lock_guard lock(mutex_);
+            advance(nowNs());
+        }
+        schedule();
+    });
+}
+
+void BarAggregator::snapshot(std::size_t count, const BarVisitor& onBar,
+                             std::uint64_t& seq) const {
+    // Copied under the lock and visited after it, so serializing does not
+    // hold up the L1 thread.
+    struct Entry {
+        SymbolId    symbol;
+        std::size_t interval;
+        Bar         bar;
+    };
+    std::vector<Entry> bars;
+    {
+        std::lock_guard lock(mutex_);
+        seq = seq_;
+        for (std::size_t symbol = 0; symbol < totalVolume_.size(); ++symbol) {
+            const auto id = static_cast<SymbolId>(symbol);
+            for (std::size_t i = 0; i < intervals_.size(); ++i) {
+                const Series& s = series_[symbol * intervals_.size() + i];
+                const std::size_t n = std::min<std::size_t>(count, s.count);
+                const Bar* ringBars = ring(id, i);
+                for (std::size_t j = 0; j < n; ++j) {
+                    bars.push_back({id, i, ringBars[(s.head + history_ - n + j) % history_]});
+                }
+            }
+        }
+    }
+    for (const auto& e : bars) onBar(e.symbol, intervals_[e.interval], e.bar);
+}
+
+void BarAggregator::writeBar(rapidjson::Writer<rapidjson::StringBuffer>& w,
+                             std::string_view symbol, const Interval& interval,
+                             const Bar& bar, std::uint64_t seq, bool snapshot) {
+    char start[40];
+    const std::size_t startLen = formatUtc(bar.startNs, start, sizeof start);
+    w.StartObject();
+    w.Key("feed");     w.String("BARS");
+    w.Key("symbol");   w.String(symbol.data(), static_cast<rapidjson::SizeType>(symbol.size()));
+    w.Key("interval"); w.String(interval.label.data(),
+                                static_cast<rapidjson::SizeType>(interval.label.size()));
+    w.Key("start");    w.String(start, static_cast<rapidjson::SizeType>(startLen));
+    w.Key("open");     writePrice(w, bar.open);
+    w.Key("high");     writePrice(w, bar.high);
+    w.Key("low");      writePrice(w, bar.low);
+    w.Key("close");    writePrice(w, bar.close);
+    w.Key("volume");   w.Int64(bar.volume);
+    w.Key("vwap");     writePrice(w, bar.vwap());
+    w.Key("trades");   w.Uint(bar.trades);
+    w.Key("seq");      w.Uint64(seq);
+    if (snapshot) {
+        w.Key("snapshot");
+        w.Bool(true);
+    }
+    w.EndObject();
+}
@@ -0,0 +1,116 @@
+// File: src/BinaryEncoder.cpp
+#include "BinaryEncoder.h"
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+namespace {
+
+enum Kind : std::uint8_t { kString = 0, kInteger = 1, kDecimal = 2 };
+
+void putVarint(std::string& out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+void putZigzag(std::string& out, std::int64_t v) {
+    putVarint(out, (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63));
+}
+
+void putFixed64(std::string& out, std::uint64_t v) {
+    char b[8];
+    for (int i = 0; i < 8; ++i) b[i] = static_cast<char>(v >> (8 * i));
+    out.append(b, 8);
+}
+
+void putBytes(std::string& out, std::string_view s) {
+    putVarint(out, s.size());
+    out.append(s.data(), s.size());
+}
+
+const char* typeName(FieldType t) {
+    switch (t) {
+    case FieldType::Integer: return "int";
+    case FieldType::Decimal: return "decimal";
+    case FieldType::String:  break;
+    }
+    return "string";
+}
+
+} // namespace
+
+void BinaryEncoder::encode(const DecodedMessage& msg, std::uint8_t feedId,
+                           char messageType, std::uint64_t seq, bool snapshot,
+                           std::string& out) {
+    const Schema& schema = *msg.schema;
+    const bool merged = msg.timestampNs != 0;
+
+    out.clear();
+    out.push_back(static_cast<char>(kVersion));
+    out.push_back(static_cast<char>(feedId));
+    out.push_back(messageType);
+    out.push_back(static_cast<char>(snapshot ? 1 : 0));
+    putFixed64(out, seq);
+    putFixed64(out, static_cast<std::uint64_t>(msg.timestampNs));
+
+    for (std::size_t idx = 0; idx < schema.fields.size(); ++idx) {
+        const int i = static_cast<int>(idx);
+        if (i == schema.messageTypeIndex) continue;
+        if (merged && (i == schema.dateIndex || i == schema.timeIndex)) continue;
+
+        const DecodedField& f = msg.fields[idx];
+        if (f.text.empty()) continue;
+        switch (f.type) {
+        case FieldType::Integer:
+            out.push_back(static_cast<char>((kInteger << 6) | idx));
+            putZigzag(out, f.i);
+            break;
+        case FieldType::Decimal:
+            out.push_back(static_cast<char>((kDecimal << 6) | idx));
+            putZigzag(out, f.i);
+            break;
+        case FieldType::String:
+            out.push_back(static_cast<char>((kString << 6) | idx));
+            putBytes(out, f.text);
+            break;
+        }
+    }
+}
+
+std::string BinaryEncoder::describe(const std::vector<FeedLayout>& feeds) {
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> w(sb);
+    w.StartObject();
+    w.Key("feed");    w.String("SYSTEM");
+    w.Key("type");    w.String("schema");
+    w.Key("format");  w.String("binary");
+    w.Key("version"); w.Uint(kVersion);
+    w.Key("decimalDigits"); w.Uint(FixedPoint::kDigits);
+    w.Key("feeds");
+    w.StartObject();
+    for (const auto& feed : feeds) {
+        const Schema& schema = *feed.schema;
+        w.Key(feed.name);
+        w.StartObject();
+        w.Key("id");
+        w.Uint(feed.id);
+        w.Key("fields");
+        w.StartArray();
+        for (std::size_t idx = 0; idx < schema.fields.size(); ++idx) {
+            w.StartObject();
+            w.Key("index"); w.Uint(static_cast<unsigned>(idx));
+            w.Key("name");
+            w.String(schema.fields[idx].data(),
+                     static_cast<rapidjson::SizeType>(schema.fields[idx].size()));
+            w.Key("type");  w.String(typeName(schema.types[idx]));
+            w.EndObject();
+        }
+        w.EndArray();
+        w.EndObject();
+    }
+    w.EndObject();
+    w.EndObject();
+    return std::string(sb.GetString(), sb.GetSize());
+}
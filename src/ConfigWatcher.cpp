@@ -0,0 +1,74 @@
+// File: src/ConfigWatcher.cpp
+#include "ConfigWatcher.h"
+#include "Logger.h"
+
+ConfigWatcher::ConfigWatcher(boost::asio::io_context& ioc,
+                             std::chrono::milliseconds interval)
+  : timer_(ioc),
+    interval_(interval)
+{}
+
+void ConfigWatcher::watch(const std::filesystem::path& path, Handler onChange) {
+    Entry e;
+    e.path     = path;
+    e.onChange = std::move(onChange);
+    e.seen     = stamp(path);
+    entries_.push_back(std::move(e));
+}
+
+void ConfigWatcher::start() {
+    schedule();
+}
+
+void ConfigWatcher::stop() {
+    stopped_ = true;
+    timer_.cancel();
+}
+
+ConfigWatcher::Stamp ConfigWatcher::stamp(const std::filesystem::path& path) {
+    Stamp s;
+    std::error_code ec;
+    s.mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return s;
+    s.size = std::filesystem::file_size(path, ec);
+    s.exists = !ec;
+    return s;
+}
+
+void ConfigWatcher::schedule() {
+    if (stopped_) return;
+    timer_.expires_after(interval_);
+    timer_.async_wait([this](const boost::system::error_code& ec) {
+        if (!ec) poll();
+    });
+}
+
+void ConfigWatcher::poll() {
+    for (auto& e : entries_) {
+        const Stamp now = stamp(e.path);
+        if (!e.changing) {
+            if (now != e.seen) {
+                e.changing = true;
+                e.pending  = now;
+            }
+            continue;
+        }
+        if (now != e.pending) {       // still being written
+            e.pending = now;
+            continue;
+        }
+        e.changing = false;
+        e.seen     = now;
+        if (!now.exists) {
+            Logger::warn("ConfigWatcher: ", e.path.string(), " disappeared; keeping current settings");
+            continue;
+        }
+        Logger::info("ConfigWatcher: ", e.path.string(), " changed, reloading");
+        try {
+            e.onChange();
+        } catch (const std::exception& ex) {
+            Logger::error("ConfigWatcher: reloading ", e.path.string(), " failed: ", ex.what());
+        }
+    }
+    schedule();
+}
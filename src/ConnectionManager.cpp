@@ -1,25 +1,60 @@
 // File: src/ConnectionManager.cpp
 #include "ConnectionManager.h"
+#include "Logger.h"
 #include <boost/asio/write.hpp>
-#include <iostream>
+#include <cstring>
+
+namespace {
+constexpr std::size_t kInitialBuffer = 64 * 1024;   // one read can carry hundreds of lines
+
+std::string endpointLabel(const std::string& host, unsigned short port) {
+    return "endpoint=\"" + host + ":" + std::to_string(port) + "\"";
+}
+}
 
 ConnectionManager::ConnectionManager(boost::asio::io_context& ioc,
                                      const std::string& host,
                                      unsigned short port)
   : ioc_(ioc),
     socket_(ioc_),
+    retryTimer_(ioc_),
     host_(host),
-    port_(port)
+    port_(port),
+    buffer_(kInitialBuffer),
+    connects_(Metrics::counter("ingest_feed_connects_total",
+        "Successful TCP connects to a feed, including reconnects", endpointLabel(host, port))),
+    readErrors_(Metrics::counter("ingest_feed_read_errors_total",
+        "Connect and read failures that triggered a reconnect", endpointLabel(host, port))),
+    lines_(Metrics::counter("ingest_feed_lines_total",
+        "Complete lines read from a feed", endpointLabel(host, port))),
+    bytes_(Metrics::counter("ingest_feed_bytes_total",
+        "Bytes read from a feed", endpointLabel(host, port))),
+    batchLatency_(Metrics::histogram("ingest_feed_batch_seconds",
+        "Time to frame one socket read and run its handlers (sampled)",
+        endpointLabel(host, port)))
 {}
 
 void ConnectionManager::setConnectHandler(ConnectHandler h) {
     onConnect_ = std::move(h);
 }
 
+void ConnectionManager::setDisconnectHandler(ConnectHandler h) {
+    onDisconnect_ = std::move(h);
+}
+
 void ConnectionManager::setMessageHandler(MessageHandler h) {
     onMessage_ = std::move(h);
 }
 
+void ConnectionManager::setBatchHandler(BatchHandler h) {
+    onBatch_ = std::move(h);
+}
+
+void ConnectionManager::setJournal(JournalWriter* journal, JournalChannel channel) {
+    journal_ = journal;
+    channel_ = channel;
+}
+
 void ConnectionManager::start() {
     doConnect();
 }
@@ -27,22 +62,39 @@ void ConnectionManager::start() {
 void ConnectionManager::stop() {
     stopped_ = true;
     boost::system::error_code ec;
+    retryTimer_.cancel();
     socket_.close(ec);
 }
 
 void ConnectionManager::send(const std::string& cmd) {
-    // post to io_context so it's safe even if called from a handler
-    std::cout << "Sending: " << cmd << "\n";
+    // post to io_context so the outbox is only touched on its thread
+    Logger::debug("Sending: ", cmd);
     boost::asio::post(ioc_, [this, cmd]() {
-        boost::system::error_code ec;
-        boost::asio::write(socket_, boost::asio::buffer(cmd), ec);
-        if (ec) {
-            std::cerr << "Send error: " << ec.message() << "\n";
-        }
+        outbox_ += cmd;
+        if (connected_ && !writing_) doWrite();
     });
 }
 
+void ConnectionManager::doWrite() {
+    writing_ = true;
+    inflight_.swap(outbox_);
+    boost::asio::async_write(socket_, boost::asio::buffer(inflight_),
+        [this](const boost::system::error_code& ec, std::size_t) {
+            writing_ = false;
+            inflight_.clear();
+            if (ec) {
+                // the read side notices the broken connection and reconnects
+                if (ec != boost::asio::error::operation_aborted) {
+                    Logger::error("Send error: ", ec.message());
+                }
+                return;
+            }
+            if (connected_ && !outbox_.empty()) doWrite();
+        });
+}
+
 void ConnectionManager::doConnect() {
+    head_ = tail_ = 0;
     auto ep = boost::asio::ip::tcp::endpoint{
         boost::asio::ip::make_address(host_), port_};
     socket_.async_connect(ep,
@@ -52,37 +104,85 @@ void ConnectionManager::doConnect() {
 void ConnectionManager::onConnect(const boost::system::error_code& ec) {
     if (stopped_) return;
     if (ec) {
-        std::cerr << "Connect error: " << ec.message() << "\n";
-        // retry after 5s
-        boost::asio::steady_timer t{ioc_, std::chrono::seconds(5)};
-        t.async_wait([this](auto){ doConnect(); });
+        Logger::warn("Connect error: ", ec.message());
+        readErrors_.inc();
+        scheduleReconnect();
         return;
     }
-    std::cout << "Connected to " << host_ << ":" << port_ << "\n";
+    Logger::info("Connected to ", host_, ":", port_);
+    connects_.inc();
+    connected_ = true;
     if (onConnect_) onConnect_();
-    doReadLine();
+    if (!writing_ && !outbox_.empty()) doWrite();
+    doRead();
+}
+
+void ConnectionManager::scheduleReconnect() {
+    outbox_.clear();
+    if (connected_) {
+        connected_ = false;
+        if (onDisconnect_) onDisconnect_();
+    }
+    // retry after 5s
+    boost::system::error_code ignored;
+    socket_.close(ignored);
+    retryTimer_.expires_after(std::chrono::seconds(5));
+    retryTimer_.async_wait([this](const boost::system::error_code& ec) {
+        if (!ec && !stopped_) doConnect();
+    });
 }
 
-void ConnectionManager::doReadLine() {
+void ConnectionManager::doRead() {
     if (stopped_) return;
-    boost::asio::async_read_until(socket_, buffer_, '\n',
-        [this](auto ec, auto n){ onReadLine(ec, n); });
+
+    // Compact the partial trailing line to the front, growing the buffer
+    // only when a single line does not fit.
+    if (head_ > 0) {
+        std::memmove(buffer_.data(), buffer_.data() + head_, tail_ - head_);
+        tail_ -= head_;
+        head_  = 0;
+    }
+    if (tail_ == buffer_.size()) buffer_.resize(buffer_.size() * 2);
+
+    socket_.async_read_some(
+        boost::asio::buffer(buffer_.data() + tail_, buffer_.size() - tail_),
+        [this](auto ec, auto n){ onRead(ec, n); });
 }
 
-void ConnectionManager::onReadLine(const boost::system::error_code& ec,
-                                   std::size_t /*n*/) {
+void ConnectionManager::onRead(const boost::system::error_code& ec,
+                               std::size_t n) {
     if (stopped_) return;
     if (ec) {
-        std::cerr << "Read error: " << ec.message() << "\n";
-        socket_.close();
-        doConnect();
+        Logger::warn("Read error: ", ec.message());
+        readErrors_.inc();
+        scheduleReconnect();
         return;
     }
-    std::istream is(&buffer_);
-    std::string line;
-    std::getline(is, line);
-    if (!line.empty() && onMessage_) {
-        onMessage_(line);
+    tail_ += n;
+    bytes_.inc(n);
+    ScopedTimer timer(batchLatency_.sample());
+
+    // Frame every complete line in place.
+    batch_.clear();
+    const char* base = buffer_.data();
+    while (head_ < tail_) {
+        const void* nl = std::memchr(base + head_, '\n', tail_ - head_);
+        if (!nl) break;
+        const std::size_t end = static_cast<const char*>(nl) - base;
+        std::size_t len = end - head_;
+        if (len > 0 && base[head_ + len - 1] == '\r') --len;
+        if (len > 0) batch_.emplace_back(base + head_, len);
+        head_ = end + 1;
+    }
+
+    if (!batch_.empty()) {
+        lines_.inc(batch_.size());
+        if (journal_) journal_->append(channel_, batch_);
+        if (onBatch_) {
+            onBatch_(batch_);
+        } else if (onMessage_) {
+            for (auto line : batch_) onMessage_(line);
+        }
     }
-    doReadLine();
+    doRead();
 }
@@ -0,0 +1,53 @@
+// File: src/Deflate.cpp
+#include "Deflate.h"
+#include <zlib.h>
+
+namespace {
+
+/// Reusable raw-deflate stream; reset between messages so every frame
+/// stands alone.
+struct Stream {
+    z_stream z{};
+    int      level{0};
+    bool     ready{false};
+
+    ~Stream() {
+        if (ready) deflateEnd(&z);
+    }
+};
+
+thread_local Stream tlsStream;
+
+constexpr std::size_t kFrameHeader = 2;
+
+} // namespace
+
+bool Deflate::compress(std::string_view payload, bool binary, int level,
+                       std::string& out)
+{
+    Stream& s = tlsStream;
+    if (!s.ready || s.level != level) {
+        if (s.ready) deflateEnd(&s.z);
+        s.z     = z_stream{};
+        s.ready = deflateInit2(&s.z, level, Z_DEFLATED, -MAX_WBITS, 8,
+                               Z_DEFAULT_STRATEGY) == Z_OK;
+        s.level = level;
+        if (!s.ready) return false;
+    } else {
+        deflateReset(&s.z);
+    }
+
+    const auto bound = deflateBound(&s.z, static_cast<uLong>(payload.size()));
+    out.resize(kFrameHeader + bound);
+    out[0] = static_cast<char>(kMarker);
+    out[1] = binary ? 1 : 0;
+
+    s.z.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(payload.data()));
+    s.z.avail_in  = static_cast<uInt>(payload.size());
+    s.z.next_out  = reinterpret_cast<Bytef*>(out.data() + kFrameHeader);
+    s.z.avail_out = static_cast<uInt>(bound);
+    if (deflate(&s.z, Z_FINISH) != Z_STREAM_END) return false;
+
+    out.resize(kFrameHeader + s.z.total_out);
+    return out.size() < payload.size();
+}
@@ -0,0 +1,139 @@
+// File: src/FeedJournal.cpp
+#include "FeedJournal.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace bip = boost::interprocess;
+using namespace FeedJournalFormat;
+
+namespace {
+
+std::int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void put(char* p, std::uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) p[i] = static_cast<char>(v >> (8 * i));
+}
+
+std::uint64_t get(const char* p, int bytes) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= std::uint64_t(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+} // namespace
+
+// — JournalWriter —
+
+JournalWriter::JournalWriter(const std::string& path, std::size_t growBytes)
+  : path_(path),
+    growBytes_(growBytes)
+{
+    { std::ofstream create(path_, std::ios::binary | std::ios::trunc); }
+    if (!std::filesystem::exists(path_)) {
+        throw std::runtime_error("JournalWriter: cannot create '" + path_ + "'");
+    }
+    open_ = true;
+    grow(sizeof(kMagic));
+    std::memcpy(region_.get_address(), kMagic, sizeof(kMagic));
+    used_ = sizeof(kMagic);
+    Logger::info("JournalWriter: capturing to ", path_);
+}
+
+JournalWriter::~JournalWriter() {
+    try { close(); } catch (...) {}
+}
+
+void JournalWriter::grow(std::size_t need) {
+    std::size_t capacity = capacity_;
+    while (capacity - used_ < need) capacity += growBytes_;
+    if (capacity == capacity_) return;
+
+    region_ = bip::mapped_region();
+    std::filesystem::resize_file(path_, capacity);
+    file_   = bip::file_mapping(path_.c_str(), bip::read_write);
+    region_ = bip::mapped_region(file_, bip::read_write, 0, capacity);
+    capacity_ = capacity;
+}
+
+void JournalWriter::append(JournalChannel channel,
+                           const std::vector<std::string_view>& lines) {
+    const std::int64_t ns = nowNs();
+    std::size_t bytes = 0;
+    for (auto line : lines) bytes += kRecordHeader + line.size();
+
+    std::lock_guard lock(mutex_);
+    if (!open_) return;
+    grow(bytes);
+    char* p = static_cast<char*>(region_.get_address()) + used_;
+    for (auto line : lines) {
+        put(p,      static_cast<std::uint64_t>(ns), 8);
+        put(p + 8,  line.size(), 4);
+        put(p + 12, static_cast<std::uint8_t>(channel), 1);
+        std::memcpy(p + kRecordHeader, line.data(), line.size());
+        p += kRecordHeader + line.size();
+    }
+    used_ += bytes;
+}
+
+void JournalWriter::close() {
+    std::lock_guard lock(mutex_);
+    if (!open_) return;
+    open_ = false;
+    region_.flush();
+    region_ = bip::mapped_region();
+    file_   = bip::file_mapping();
+    std::filesystem::resize_file(path_, used_);
+    Logger::info("JournalWriter: closed ", path_, " (", used_, " bytes)");
+}
+
+// — JournalReader —
+
+JournalReader::JournalReader(const std::string& path)
+  : file_(path.c_str(), bip::read_only),
+    region_(file_, bip::read_only)
+{
+    if (region_.get_size() < sizeof(kMagic) ||
+        std::memcmp(region_.get_address(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("JournalReader: '" + path + "' is not a feed journal");
+    }
+}
+
+std::size_t JournalReader::replay(const Handler& handler, double speed) const {
+    const char* base = static_cast<const char*>(region_.get_address());
+    const std::size_t size = region_.get_size();
+
+    std::size_t   count = 0;
+    std::size_t   pos   = sizeof(kMagic);
+    std::int64_t  first = 0;
+    const auto    start = std::chrono::steady_clock::now();
+
+    while (pos + kRecordHeader <= size) {
+        const auto ns  = static_cast<std::int64_t>(get(base + pos, 8));
+        const auto len = static_cast<std::size_t>(get(base + pos + 8, 4));
+        const auto ch  = static_cast<JournalChannel>(base[pos + 12]);
+        if (ns == 0 && len == 0) break;                  // unused tail
+        if (pos + kRecordHeader + len > size) {
+            Logger::warn("JournalReader: truncated record at offset ", pos);
+            break;
+        }
+
+        if (speed > 0.0) {
+            if (count == 0) first = ns;
+            const auto due = start + std::chrono::nanoseconds(
+                static_cast<std::int64_t>((ns - first) / speed));
+            std::this_thread::sleep_until(due);
+        }
+        handler(ch, std::string_view(base + pos + kRecordHeader, len));
+        pos += kRecordHeader + len;
+        ++count;
+    }
+    return count;
+}
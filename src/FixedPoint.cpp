@@ -0,0 +1,84 @@
+// File: src/FixedPoint.cpp
+#include "FixedPoint.h"
+#include <limits>
+
+namespace {
+
+constexpr std::uint64_t kPow10[FixedPoint::kDigits + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+constexpr std::uint64_t kMaxWhole =
+    static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) / FixedPoint::kScale;
+
+inline bool isDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+} // namespace
+
+bool FixedPoint::parse(std::string_view text, std::int64_t& out)
+{
+    const char* p   = text.data();
+    const char* end = p + text.size();
+    if (p == end) return false;
+
+    const bool negative = *p == '-';
+    if (*p == '-' || *p == '+') ++p;
+
+    // whole part: kMaxWhole has 11 digits, so 10 can never overflow
+    std::uint64_t whole = 0;
+    const char* digits = p;
+    while (p != end && isDigit(*p)) {
+        whole = whole * 10 + static_cast<unsigned>(*p - '0');
+        if (whole > kMaxWhole) return false;
+        ++p;
+    }
+    bool any = p != digits;
+
+    std::uint64_t frac = 0;
+    if (p != end && *p == '.') {
+        ++p;
+        const char* fracStart = p;
+        while (p != end && isDigit(*p) && p - fracStart < kDigits) {
+            frac = frac * 10 + static_cast<unsigned>(*p - '0');
+            ++p;
+        }
+        const auto used = static_cast<int>(p - fracStart);
+        any = any || used > 0;
+        frac *= kPow10[kDigits - used];
+        if (p != end && isDigit(*p)) {
+            if (*p >= '5') ++frac;                  // round on the first dropped digit
+            while (p != end && isDigit(*p)) ++p;
+        }
+    }
+    if (!any || p != end) return false;
+
+    const std::uint64_t mag = whole * static_cast<std::uint64_t>(kScale) + frac;
+    if (mag > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) return false;
+    out = negative ? -static_cast<std::int64_t>(mag) : static_cast<std::int64_t>(mag);
+    return true;
+}
+
+std::size_t FixedPoint::format(std::int64_t v, char* out)
+{
+    char* p = out;
+    std::uint64_t mag = v < 0 ? 0 - static_cast<std::uint64_t>(v)
+                              : static_cast<std::uint64_t>(v);
+    if (v < 0) *p++ = '-';
+
+    std::uint64_t whole = mag / kScale;
+    std::uint64_t frac  = mag % kScale;
+
+    char digits[20];
+    int n = 0;
+    do { digits[n++] = static_cast<char>('0' + whole % 10); whole /= 10; } while (whole);
+    while (n) *p++ = digits[--n];
+
+    if (frac != 0) {
+        int len = kDigits;
+        while (frac % 10 == 0) { frac /= 10; --len; }
+        *p++ = '.';
+        for (int i = len - 1; i >= 0; --i) { p[i] = static_cast<char>('0' + frac % 10); frac /= 10; }
+        p += len;
+    }
+    return static_cast<std::size_t>(p - out);
+}
@@ -0,0 +1,88 @@
+// File: src/LastValueCache.cpp
+#include "LastValueCache.h"
+
+LastValueCache::LastValueCache(const Schema& l2)
+  : books_(l2)
+{}
+
+std::uint64_t LastValueCache::updateL1(const DecodedMessage& msg) {
+    std::lock_guard lock(l1Mutex_);
+    ++l1Seq_;
+    if (msg.symbol != kNoSymbol) {
+        if (msg.symbol >= l1Records_.size()) l1Records_.resize(msg.symbol + 1);
+        L1Record& rec = l1Records_[msg.symbol];
+        if (rec.schema != msg.schema) {
+            // columns moved: last values under the old layout no longer apply
+            rec = L1Record{};
+            rec.schema = msg.schema;
+        }
+        for (std::size_t idx = 0; idx < msg.schema->fields.size(); ++idx) {
+            const DecodedField& f = msg.fields[idx];
+            if (f.text.empty()) continue;           // blank keeps last value
+            rec.text[idx].assign(f.text.data(), f.text.size());
+            rec.value[idx] = f;
+        }
+        rec.seq = l1Seq_;
+    }
+    return l1Seq_;
+}
+
+OrderBook* LastValueCache::applyL2(const DecodedMessage& msg, std::uint64_t& seq) {
+    std::lock_guard lock(bookMutex_);
+    OrderBook* book = books_.apply(msg);
+    if (book) seq = ++bookSeq_;
+    return book;
+}
+
+bool LastValueCache::latestL1(SymbolId symbol, std::uint64_t& seq,
+                              const L1Visitor& onL1) const {
+    std::lock_guard lock(l1Mutex_);
+    if (symbol >= l1Records_.size() || l1Records_[symbol].seq == 0) {
+        seq = 0;
+        return false;
+    }
+    const L1Record& rec = l1Records_[symbol];
+    if (rec.seq == seq) return true;
+    seq = rec.seq;
+    DecodedMessage msg;
+    view(symbol, rec, msg);
+    onL1(msg);
+    return true;
+}
+
+void LastValueCache::view(SymbolId symbol, const L1Record& rec, DecodedMessage& msg) const {
+    msg.schema = rec.schema;
+    msg.symbol = symbol;
+    for (std::size_t idx = 0; idx < rec.schema->fields.size(); ++idx) {
+        msg.fields[idx]      = rec.value[idx];
+        msg.fields[idx].text = rec.text[idx];
+    }
+}
+
+void LastValueCache::snapshot(const SymbolFilter& wantL1, const SymbolFilter& wantBook,
+                              std::size_t bookDepth,
+                              const L1Visitor& onL1, const BookVisitor& onBook,
+                              std::uint64_t& l1Seq, std::uint64_t& bookSeq) const {
+    std::vector<std::pair<SymbolId, L1Record>>  records;
+    std::vector<std::pair<SymbolId, OrderBook>> books;
+    {
+        std::scoped_lock lock(l1Mutex_, bookMutex_);
+        l1Seq   = l1Seq_;
+        bookSeq = bookSeq_;
+        for (std::size_t id = 0; id < l1Records_.size(); ++id) {
+            const auto symbol = static_cast<SymbolId>(id);
+            if (l1Records_[id].seq == 0 || !wantL1(symbol)) continue;
+            records.emplace_back(symbol, l1Records_[id]);
+        }
+        books_.forEach([&](SymbolId symbol, const OrderBook& book) {
+            if (wantBook(symbol)) books.emplace_back(symbol, book.top(bookDepth));
+        });
+    }
+
+    DecodedMessage msg;
+    for (const auto& [symbol, rec] : records) {
+        view(symbol, rec, msg);
+        onL1(msg);
+    }
+    for (const auto& [symbol, book] : books) onBook(symbol, book);
+}
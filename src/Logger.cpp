@@ -0,0 +1,172 @@
+// File: src/Logger.cpp
+#include "Logger.h"
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <thread>
+
+namespace {
+
+/// One ring entry. `seq` follows the bounded MPMC queue scheme: a slot is
+/// free for position p when seq == p and readable when seq == p + 1.
+struct Record {
+    std::atomic<std::uint64_t> seq;
+    std::int64_t               ns;      ///< wall clock, ns since epoch
+    LogLevel                   level;
+    std::uint16_t              len;
+    char                       text[Logger::kMaxMessage];
+};
+
+std::unique_ptr<Record[]>  ring;
+std::size_t                mask = 0;
+alignas(64) std::atomic<std::uint64_t> enqueuePos{0};
+alignas(64) std::uint64_t              dequeuePos = 0;   // writer thread only
+std::atomic<std::uint64_t> droppedCount{0};
+std::atomic<bool>          running{false};
+std::atomic<bool>          stopping{false};
+std::thread                writer;
+
+const char* levelName(LogLevel lvl) {
+    switch (lvl) {
+    case LogLevel::Trace: return "TRACE";
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info:  return "INFO ";
+    case LogLevel::Warn:  return "WARN ";
+    case LogLevel::Error: return "ERROR";
+    case LogLevel::Off:   break;
+    }
+    return "?    ";
+}
+
+std::int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+/// Format "2025-06-22T15:34:12.123456Z LEVEL message\n" and write it out.
+void emit(std::int64_t ns, LogLevel lvl, std::string_view msg) {
+    const std::time_t secs = static_cast<std::time_t>(ns / 1000000000);
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &secs);
+#else
+    gmtime_r(&secs, &tm);
+#endif
+    char prefix[48];
+    const int n = std::snprintf(prefix, sizeof prefix,
+                                "%04d-%02d-%02dT%02d:%02d:%02d.%06dZ %s ",
+                                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                                tm.tm_hour, tm.tm_min, tm.tm_sec,
+                                static_cast<int>((ns / 1000) % 1000000),
+                                levelName(lvl));
+    std::FILE* out = lvl >= LogLevel::Warn ? stderr : stdout;
+    std::fwrite(prefix, 1, static_cast<std::size_t>(n), out);
+    std::fwrite(msg.data(), 1, msg.size(), out);
+    std::fputc('\n', out);
+}
+
+/// Write every readable record; returns how many there were.
+std::size_t drain() {
+    std::size_t count = 0;
+    for (;;) {
+        Record& r = ring[dequeuePos & mask];
+        if (r.seq.load(std::memory_order_acquire) != dequeuePos + 1) break;
+        emit(r.ns, r.level, std::string_view(r.text, r.len));
+        r.seq.store(dequeuePos + mask + 1, std::memory_order_release);
+        ++dequeuePos;
+        ++count;
+    }
+    return count;
+}
+
+void run() {
+    std::uint64_t reportedDrops = 0;
+    while (!stopping.load(std::memory_order_acquire)) {
+        if (drain() == 0) {
+            std::fflush(stdout);
+            std::fflush(stderr);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const auto d = droppedCount.load(std::memory_order_relaxed);
+        if (d != reportedDrops) {
+            emit(nowNs(), LogLevel::Warn,
+                 "Logger: ring full, " + std::to_string(d - reportedDrops) + " records dropped");
+            reportedDrops = d;
+        }
+    }
+    drain();
+    std::fflush(stdout);
+    std::fflush(stderr);
+}
+
+} // namespace
+
+std::atomic<std::uint8_t> Logger::level_{static_cast<std::uint8_t>(LogLevel::Info)};
+
+void Logger::start(std::size_t capacity) {
+    if (running.load()) return;
+    std::size_t size = 1;
+    while (size < capacity) size <<= 1;
+    ring.reset(new Record[size]);
+    for (std::size_t i = 0; i < size; ++i) ring[i].seq.store(i, std::memory_order_relaxed);
+    mask = size - 1;
+    enqueuePos.store(0);
+    dequeuePos = 0;
+    stopping.store(false);
+    writer = std::thread(run);
+    running.store(true, std::memory_order_release);
+}
+
+void Logger::stop() {
+    if (!running.exchange(false)) return;
+    stopping.store(true, std::memory_order_release);
+    writer.join();
+}
+
+void Logger::setLevel(LogLevel lvl) {
+    level_.store(static_cast<std::uint8_t>(lvl), std::memory_order_relaxed);
+}
+
+LogLevel Logger::parseLevel(const std::string& name) {
+    if (name == "trace") return LogLevel::Trace;
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "warn")  return LogLevel::Warn;
+    if (name == "error") return LogLevel::Error;
+    if (name == "off")   return LogLevel::Off;
+    return LogLevel::Info;
+}
+
+std::uint64_t Logger::dropped() {
+    return droppedCount.load(std::memory_order_relaxed);
+}
+
+void Logger::write(LogLevel lvl, std::string_view msg) {
+    const std::int64_t ns = nowNs();
+    if (!running.load(std::memory_order_acquire)) {
+        emit(ns, lvl, msg);
+        return;
+    }
+
+    // Claim a slot; never wait for the writer.
+    std::uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Record* r;
+    for (;;) {
+        r = &ring[pos & mask];
+        const std::uint64_t seq = r->seq.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::int64_t>(seq - pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    r->ns    = ns;
+    r->level = lvl;
+    r->len   = static_cast<std::uint16_t>(msg.size());
+    std::memcpy(r->text, msg.data(), msg.size());
+    r->seq.store(pos + 1, std::memory_order_release);
+}
@@ -1,127 +1,231 @@
 // File: src/MessageDecoder.cpp
 #include "MessageDecoder.h"
-#include <rapidjson/document.h>        // rapidjson::Document / Value
-#include <string>
-#include <vector>
-#include <unordered_set>
-#include <iostream>
-#include <algorithm>                   // std::replace, std::transform
-#include <cctype>                      // std::tolower
+#include "Logger.h"
+#include <charconv>                    // std::from_chars
+#include <cstdint>
+#include <cstring>                     // std::memcpy
 
 // ---------------------------------------------------------------------------
-// helper: trim ASCII whitespace from both ends (in‑place)
-static inline void trim(std::string& s)
+// helper: trim ASCII whitespace from both ends (view only, no copy)
+static inline std::string_view trim(std::string_view s)
 {
     const char* ws = " \t\r\n";
     const auto first = s.find_first_not_of(ws);
-    if (first == std::string::npos) { s.clear(); return; }  // all whitespace
+    if (first == std::string_view::npos) return {};          // all whitespace
     const auto last  = s.find_last_not_of(ws);
-    s.erase(last + 1);
-    s.erase(0, first);
+    return s.substr(first, last - first + 1);
 }
 
-bool MessageDecoder::decode(const std::vector<std::string>& keys,
-                            const std::string& csvLine,
-                            rapidjson::Document& doc)
+// helper: fixed-width run of ASCII digits → value, false on a non-digit
+static inline bool digits(const char* p, int n, int& out)
 {
-    if (keys.empty()) {
-        std::cerr << "MessageDecoder: empty schema\n";
+    int v = 0;
+    for (int i = 0; i < n; ++i) {
+        const unsigned d = static_cast<unsigned char>(p[i] - '0');
+        if (d > 9) return false;
+        v = v * 10 + static_cast<int>(d);
+    }
+    out = v;
+    return true;
+}
+
+// helper: "YYYY-MM-DD" → days since 1970-01-01 (proleptic Gregorian)
+static bool parseDate(std::string_view s, std::int64_t& days)
+{
+    int y, m, d;
+    if (s.size() != 10 || s[4] != '-' || s[7] != '-' ||
+        !digits(s.data(), 4, y) || !digits(s.data() + 5, 2, m) ||
+        !digits(s.data() + 8, 2, d) || m < 1 || m > 12 || d < 1 || d > 31) {
         return false;
     }
+    y -= m <= 2;
+    const int era = y / 400;
+    const int yoe = y - era * 400;
+    const int doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    days = static_cast<std::int64_t>(era) * 146097 + doe - 719468;
+    return true;
+}
 
-    // ---- canonicaliser: "Order Size" → "order-size"
-    auto canonical = [](std::string s) {
-        std::replace(s.begin(), s.end(), ' ', '-');
-        std::transform(s.begin(), s.end(), s.begin(),
-                       [](unsigned char c){ return std::tolower(c); });
-        return s;
-    };
-
-    // ---- numeric field hints (lower‑case, dashes only!)
-    static const std::unordered_set<std::string> intFields = {
-        "most-recent-trade-size", "total-volume",
-        "bid-size", "ask-size", "order-size", "level-size"
-    };
-    static const std::unordered_set<std::string> floatFields = {
-        "most-recent-trade", "bid", "ask", "open",
-        "high", "low", "close", "price"
-    };
-
-    // ----------------------------------------------------------------------
-    doc.SetObject();
-    auto& alloc = doc.GetAllocator();
-    std::string dateStr, timeStr;
-
-    // --- CSV split (preserve empty fields) ---------------------------------
-    std::vector<std::string> tokens;
-    size_t start = 0;
+// helper: "HH:MM:SS[.f…]" → ns since midnight; digits past 9 are dropped
+static bool parseTime(std::string_view s, std::int64_t& ns)
+{
+    int h, m, sec;
+    if (s.size() < 8 || s[2] != ':' || s[5] != ':' ||
+        !digits(s.data(), 2, h) || !digits(s.data() + 3, 2, m) ||
+        !digits(s.data() + 6, 2, sec)) {
+        return false;
+    }
+    std::int64_t frac = 0;
+    std::size_t pos = 8;
+    if (pos < s.size()) {
+        if (s[pos++] != '.') return false;
+        std::int64_t scale = 100000000;
+        for (; pos < s.size(); ++pos, scale /= 10) {
+            const unsigned d = static_cast<unsigned char>(s[pos] - '0');
+            if (d > 9) return false;
+            frac += d * scale;
+        }
+    }
+    ns = ((h * 60 + m) * 60 + sec) * 1000000000ll + frac;
+    return true;
+}
+
+// The feed stamps every row with the trading date, so the ISO prefix and
+// its epoch offset are worked out once per date change, per thread.
+struct DatePrefix {
+    char          iso[11];    // "YYYY-MM-DDT"
+    std::int64_t  epochNs{0};
+    bool          valid{false};
+};
+static thread_local DatePrefix _datePrefix;
+
+// Order-remove rows ('5') omit these columns; they are padded as blanks so
+// the remaining tokens line up with the depth schema.
+static constexpr std::uint64_t kRemovePadMask =
+    (1ull << 3) | (1ull << 5) | (1ull << 6) | (1ull << 7) |
+    (1ull << 8) | (1ull << 9) | (1ull << 10);
+
+bool MessageDecoder::decode(const Schema& schema,
+                            std::string_view csvLine,
+                            DecodedMessage& out)
+{
+    const std::size_t count = schema.fields.size();
+    if (count == 0) {
+        Logger::error("MessageDecoder: empty schema");
+        return false;
+    }
+
+    out.schema    = &schema;
+    out.timestamp = {};
+    out.timestampNs = 0;
+    out.symbol    = kNoSymbol;
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        out.fields[idx] = DecodedField{};
+    }
+
+    // --- CSV split in place (preserve empty fields) ------------------------
+    const bool orderRemove = csvLine.substr(0, csvLine.find(',')) == "5";
+    std::size_t field = 0, start = 0;
     while (true) {
-        size_t end = csvLine.find(',', start);
-        tokens.emplace_back(csvLine.substr(
+        if (orderRemove) {
+            while (field < Schema::kMaxFields && ((kRemovePadMask >> field) & 1u)) ++field;
+        }
+        if (field >= count) break;
+
+        const std::size_t end = csvLine.find(',', start);
+        out.fields[field++].text = trim(csvLine.substr(
             start,
-            end == std::string::npos ? end : end - start));
-        if (end == std::string::npos) break;
+            end == std::string_view::npos ? end : end - start));
+        if (end == std::string_view::npos) break;
         start = end + 1;
     }
 
-    // --- message‑type specific padding (order‑remove = '5')
-    if (!tokens.empty() && tokens[0] == "5") {
-        const std::vector<size_t> omit = {3,5,6,7,8,9,10};
-        for (size_t i = 0; i < omit.size(); ++i) {
-            size_t pos = omit[i];
-            if (pos <= tokens.size())
-                tokens.insert(tokens.begin() + pos, std::string());
+    // --- symbol → dense id, once per row -----------------------------------
+    if (schema.symbolIndex >= 0) {
+        out.symbol = SymbolTable::intern(out.fields[schema.symbolIndex].text);
+    }
+
+    // --- typed conversion from the compiled type table ---------------------
+    for (std::size_t idx = 0; idx < count; ++idx) {
+        DecodedField& f = out.fields[idx];
+        if (f.text.empty()) continue;                     // JSON null
+
+        const char* first = f.text.data();
+        const char* last  = first + f.text.size();
+        switch (schema.types[idx]) {
+        case FieldType::Integer: {
+            auto [ptr, ec] = std::from_chars(first, last, f.i);
+            if (ec == std::errc() && ptr == last) f.type = FieldType::Integer;
+            break;
+        }
+        case FieldType::Decimal:
+            if (FixedPoint::parse(f.text, f.i)) f.type = FieldType::Decimal;
+            break;
+        case FieldType::String:
+            break;
         }
+        // anything that failed to parse stays a plain string
     }
 
-    // --- main field loop ---------------------------------------------------
-    for (size_t idx = 0; idx < keys.size(); ++idx) {
-        std::string token = (idx < tokens.size() ? tokens[idx] : "");
-        trim(token);
+    // --- merge Date + Time into ISO‑8601 timestamp -------------------------
+    if (schema.dateIndex >= 0 && schema.timeIndex >= 0) {
+        const std::string_view date = out.fields[schema.dateIndex].text;
+        const std::string_view time = out.fields[schema.timeIndex].text;
+        if (!date.empty() && !time.empty() &&
+            date.size() + time.size() + 2 <= sizeof(out.timestampBuf_)) {
+            DatePrefix& cached = _datePrefix;
+            if (!cached.valid || date.size() != 10 ||
+                std::memcmp(cached.iso, date.data(), 10) != 0) {
+                std::int64_t days = 0;
+                cached.valid = parseDate(date, days);
+                if (cached.valid) {
+                    std::memcpy(cached.iso, date.data(), 10);
+                    cached.iso[10] = 'T';
+                    cached.epochNs = days * 86400000000000ll;
+                }
+            }
 
-        const std::string& fieldName = keys[idx];
-        const std::string  canon     = canonical(fieldName);
+            char* p = out.timestampBuf_;
+            if (cached.valid) {
+                std::memcpy(p, cached.iso, sizeof cached.iso);
+                p += sizeof cached.iso;
+                std::int64_t ns = 0;
+                if (parseTime(time, ns)) out.timestampNs = cached.epochNs + ns;
+            } else {
+                // not a plain date: merge the text as-is, without epoch time
+                std::memcpy(p, date.data(), date.size()); p += date.size();
+                *p++ = 'T';
+            }
+            std::memcpy(p, time.data(), time.size()); p += time.size();
+            *p++ = 'Z';
+            out.timestamp = std::string_view(out.timestampBuf_,
+                                             p - out.timestampBuf_);
+        }
+    }
 
-        if (fieldName == "Date") dateStr = token;
-        if (fieldName == "Time") timeStr = token;
+    return true;   // decode succeeded
+}
+
+void MessageDecoder::writeFields(const DecodedMessage& msg,
+                                 rapidjson::Writer<rapidjson::StringBuffer>& w)
+{
+    const Schema& schema = *msg.schema;
+    const bool merged = !msg.timestamp.empty();
+
+    std::uint64_t skip = merged ? schema.dateTimeMask : 0;
+    if (schema.messageTypeIndex >= 0) skip |= 1ull << schema.messageTypeIndex;
+
+    for (std::size_t idx = 0; idx < schema.fields.size(); ++idx) {
+        if ((skip >> idx) & 1u) continue;
 
-        rapidjson::Value key(fieldName.c_str(), alloc);  // JSON key
+        const std::string&  key = schema.jsonKeys[idx];
+        const DecodedField& f   = msg.fields[idx];
+        w.RawValue(key.data(), key.size(), rapidjson::kStringType);
 
-        // empty → JSON null
-        if (token.empty()) {
-            doc.AddMember(key, rapidjson::Value(rapidjson::kNullType), alloc);
+        if (f.text.empty()) {
+            w.Null();
             continue;
         }
-
-        try {
-            if (intFields.count(canon)) {                // integer
-                long long v = std::stoll(token);
-                doc.AddMember(key, rapidjson::Value(v), alloc);
-            } else if (floatFields.count(canon)) {       // floating‑point
-                double v = std::stod(token);
-                doc.AddMember(key, rapidjson::Value(v), alloc);
-            } else {                                     // plain string
-                doc.AddMember(key,
-                              rapidjson::Value(token.c_str(), alloc),
-                              alloc);
-            }
+        switch (f.type) {
+        case FieldType::Integer:
+            w.Int64(f.i);
+            break;
+        case FieldType::Decimal: {
+            char buf[FixedPoint::kMaxChars];
+            // RawValue, not RawNumber: RawNumber writes its text as a string
+            w.RawValue(buf, FixedPoint::format(f.i, buf), rapidjson::kNumberType);
+            break;
         }
-        catch (...) {                                    // fallback to string
-            doc.AddMember(key,
-                          rapidjson::Value(token.c_str(), alloc),
-                          alloc);
+        case FieldType::String:
+            w.String(f.text.data(), static_cast<rapidjson::SizeType>(f.text.size()));
+            break;
         }
     }
 
-    // --- merge Date + Time into ISO‑8601 timestamp -------------------------
-    if (!dateStr.empty() && !timeStr.empty()) {
-        std::string iso = dateStr + "T" + timeStr + "Z";
-        doc.AddMember(rapidjson::Value("timestamp", alloc),
-                      rapidjson::Value(iso.c_str(), alloc),
-                      alloc);
-        doc.RemoveMember("Date");
-        doc.RemoveMember("Time");
+    if (merged) {
+        w.Key("timestamp");
+        w.String(msg.timestamp.data(),
+                 static_cast<rapidjson::SizeType>(msg.timestamp.size()));
     }
-
-    return true;   // decode succeeded
 }
@@ -0,0 +1,167 @@
+// File: src/Metrics.cpp
+#include "Metrics.h"
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <variant>
+#include <vector>
+
+namespace {
+
+struct Series {
+    std::string labels;
+    std::variant<std::unique_ptr<Counter>, std::unique_ptr<Gauge>,
+                 std::unique_ptr<Histogram>> metric;
+};
+
+struct Family {
+    std::string         help;
+    const char*         type;
+    std::deque<Series>  series;
+};
+
+std::mutex                     registryMutex;
+std::map<std::string, Family>  families;      // sorted for stable output
+std::vector<Metrics::Collector> collectors;
+
+template <typename T>
+T& registerMetric(const std::string& name, const std::string& help,
+                  const std::string& labels, const char* type) {
+    std::lock_guard lock(registryMutex);
+    Family& f = families[name];
+    if (f.help.empty()) {
+        f.help = help;
+        f.type = type;
+    }
+    for (auto& s : f.series) {
+        if (s.labels == labels) return *std::get<std::unique_ptr<T>>(s.metric);
+    }
+    f.series.push_back(Series{labels, std::make_unique<T>()});
+    return *std::get<std::unique_ptr<T>>(f.series.back().metric);
+}
+
+std::string withLabels(const std::string& name, const std::string& labels,
+                       const std::string& extra = {}) {
+    if (labels.empty() && extra.empty()) return name;
+    std::string out = name + "{" + labels;
+    if (!labels.empty() && !extra.empty()) out += ",";
+    return out + extra + "}";
+}
+
+void appendSeconds(std::string& out, std::uint64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.9g", ns / 1e9);
+    out += buf;
+}
+
+} // namespace
+
+std::size_t MetricsDetail::shard() {
+    static std::atomic<std::size_t> next{0};
+    thread_local const std::size_t mine = next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return mine;
+}
+
+std::uint64_t Counter::value() const {
+    std::uint64_t total = 0;
+    for (const auto& c : cells_) total += c.v.load(std::memory_order_relaxed);
+    return total;
+}
+
+std::atomic<std::uint32_t> Histogram::interval_{1};
+
+void Histogram::setSamplingInterval(std::uint32_t n) {
+    std::uint32_t p = 1;
+    while (p * 2 <= n && p < (1u << 30)) p *= 2;
+    interval_.store(p, std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::upperBound(std::size_t i) {
+    if (i < (1u << kSubBits)) return i;
+    const int e = static_cast<int>(i >> kSubBits) + kSubBits - 1;
+    const std::uint64_t sub = i & ((1u << kSubBits) - 1);
+    const std::uint64_t lower = ((1ull << kSubBits) + sub) << (e - kSubBits);
+    return lower + (1ull << (e - kSubBits)) - 1;
+}
+
+Histogram::Summary Histogram::summarize() const {
+    std::array<std::uint64_t, kBuckets> merged{};
+    Summary s;
+    for (const auto& shard : shards_) {
+        for (std::size_t i = 0; i < kBuckets; ++i) {
+            merged[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+        s.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    for (auto c : merged) s.count += c;
+    if (s.count == 0) return s;
+
+    const std::pair<double, std::uint64_t*> targets[] = {
+        {0.50, &s.p50}, {0.90, &s.p90}, {0.99, &s.p99}, {0.999, &s.p999}, {1.0, &s.max}};
+    std::uint64_t seen = 0;
+    std::size_t   t    = 0;
+    for (std::size_t i = 0; i < kBuckets && t < std::size(targets); ++i) {
+        seen += merged[i];
+        while (t < std::size(targets) &&
+               seen >= static_cast<std::uint64_t>(targets[t].first * s.count + 0.5) && seen > 0) {
+            *targets[t].second = upperBound(i);
+            ++t;
+        }
+    }
+    return s;
+}
+
+Counter& Metrics::counter(const std::string& name, const std::string& help,
+                          const std::string& labels) {
+    return registerMetric<Counter>(name, help, labels, "counter");
+}
+
+Gauge& Metrics::gauge(const std::string& name, const std::string& help,
+                      const std::string& labels) {
+    return registerMetric<Gauge>(name, help, labels, "gauge");
+}
+
+Histogram& Metrics::histogram(const std::string& name, const std::string& help,
+                              const std::string& labels) {
+    return registerMetric<Histogram>(name, help, labels, "summary");
+}
+
+void Metrics::addCollector(Collector c) {
+    std::lock_guard lock(registryMutex);
+    collectors.push_back(std::move(c));
+}
+
+std::string Metrics::render() {
+    std::string out;
+    out.reserve(16 * 1024);
+    std::lock_guard lock(registryMutex);
+    for (const auto& [name, family] : families) {
+        out += "# HELP " + name + " " + family.help + "\n";
+        out += "# TYPE " + name + " " + family.type + "\n";
+        for (const auto& s : family.series) {
+            if (auto* c = std::get_if<std::unique_ptr<Counter>>(&s.metric)) {
+                out += withLabels(name, s.labels) + " " + std::to_string((*c)->value()) + "\n";
+            } else if (auto* g = std::get_if<std::unique_ptr<Gauge>>(&s.metric)) {
+                out += withLabels(name, s.labels) + " " + std::to_string((*g)->value()) + "\n";
+            } else if (auto* h = std::get_if<std::unique_ptr<Histogram>>(&s.metric)) {
+                const auto sum = (*h)->summarize();
+                const std::pair<const char*, std::uint64_t> qs[] = {
+                    {"0.5", sum.p50}, {"0.9", sum.p90}, {"0.99", sum.p99},
+                    {"0.999", sum.p999}, {"1", sum.max}};
+                for (const auto& [q, v] : qs) {
+                    out += withLabels(name, s.labels, std::string("quantile=\"") + q + "\"") + " ";
+                    appendSeconds(out, v);
+                    out += "\n";
+                }
+                out += withLabels(name + "_sum", s.labels) + " ";
+                appendSeconds(out, sum.sum);
+                out += "\n" + withLabels(name + "_count", s.labels) + " " +
+                       std::to_string(sum.count) + "\n";
+            }
+        }
+    }
+    for (const auto& c : collectors) c(out);
+    return out;
+}
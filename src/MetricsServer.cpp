@@ -0,0 +1,81 @@
+// File: src/MetricsServer.cpp
+#include "MetricsServer.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include <boost/beast.hpp>
+#include <memory>
+
+using tcp      = boost::asio::ip::tcp;
+namespace http = boost::beast::http;
+
+namespace {
+
+/// One scrape: read the request, answer, close.
+class Exchange : public std::enable_shared_from_this<Exchange> {
+public:
+    explicit Exchange(tcp::socket socket) : stream_(std::move(socket)) {}
+
+    void start() {
+        stream_.expires_after(std::chrono::seconds(10));
+        http::async_read(stream_, buffer_, request_,
+            [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+                self->onRead(ec);
+            });
+    }
+
+private:
+    void onRead(boost::beast::error_code ec) {
+        if (ec) return;   // client went away; nothing to answer
+        response_.version(request_.version());
+        response_.keep_alive(false);
+        response_.set(http::field::server, "ingest_server");
+        if (request_.method() == http::verb::get &&
+            request_.target().substr(0, 8) == "/metrics") {
+            response_.result(http::status::ok);
+            response_.set(http::field::content_type, "text/plain; version=0.0.4");
+            response_.body() = Metrics::render();
+        } else {
+            response_.result(http::status::not_found);
+            response_.set(http::field::content_type, "text/plain");
+            response_.body() = "not found\n";
+        }
+        response_.prepare_payload();
+        http::async_write(stream_, response_,
+            [self = shared_from_this()](boost::beast::error_code, std::size_t) {
+                boost::beast::error_code ignored;
+                self->stream_.socket().shutdown(tcp::socket::shutdown_send, ignored);
+            });
+    }
+
+    boost::beast::tcp_stream                   stream_;
+    boost::beast::flat_buffer                  buffer_;
+    http::request<http::string_body>           request_;
+    http::response<http::string_body>          response_;
+};
+
+} // namespace
+
+MetricsServer::MetricsServer(boost::asio::io_context& ioc,
+                             const std::string& address,
+                             unsigned short port)
+  : ioc_(ioc),
+    acceptor_{ioc_, {boost::asio::ip::make_address(address), port}}
+{}
+
+void MetricsServer::start() {
+    Logger::info("Metrics on http://", acceptor_.local_endpoint().address().to_string(),
+                 ":", port(), "/metrics");
+    doAccept();
+}
+
+void MetricsServer::doAccept() {
+    acceptor_.async_accept(ioc_,
+        [this](boost::system::error_code ec, tcp::socket sock) {
+            if (!ec) {
+                std::make_shared<Exchange>(std::move(sock))->start();
+            } else {
+                Logger::error("MetricsServer: accept error: ", ec.message());
+            }
+            doAccept();
+        });
+}
@@ -0,0 +1,271 @@
+// File: src/OrderBook.cpp
+#include "OrderBook.h"
+#include <algorithm>
+#include <charconv>
+
+// ---------------------------------------------------------------------------
+// helper: write a scaled price as an exact JSON number ("157.25", "3")
+static void writePrice(rapidjson::Writer<rapidjson::StringBuffer>& w, std::int64_t price)
+{
+    char buf[FixedPoint::kMaxChars];
+    w.RawValue(buf, FixedPoint::format(price, buf), rapidjson::kNumberType);
+}
+
+// — OrderBook —
+
+void OrderBook::addOrder(std::uint64_t id, Side side,
+                         std::int64_t price, std::int64_t size) {
+    modifyOrder(id, side, price, size);   // a repeated add replaces the order
+}
+
+void OrderBook::modifyOrder(std::uint64_t id, Side side,
+                            std::int64_t price, std::int64_t size) {
+    if (size <= 0) { removeOrder(id); return; }
+
+    auto it = orders_.find(id);
+    if (it == orders_.end()) {
+        orders_.emplace(id, Order{side, price, size});
+        adjust(side, price, size, +1);
+        return;
+    }
+    Order& o = it->second;
+    if (o.side == side && o.price == price) {
+        adjust(side, price, size - o.size, 0);
+    } else {
+        adjust(o.side, o.price, -o.size, -1);
+        adjust(side, price, size, +1);
+    }
+    o = Order{side, price, size};
+}
+
+void OrderBook::removeOrder(std::uint64_t id) {
+    auto it = orders_.find(id);
+    if (it == orders_.end()) return;
+    adjust(it->second.side, it->second.price, -it->second.size, -1);
+    orders_.erase(it);
+}
+
+void OrderBook::setLevel(Side side, std::int64_t price, std::int64_t size) {
+    if (size <= 0) { removeLevel(side, price); return; }
+    auto& l = ladder(side);
+    auto it = side == Side::Bid
+        ? std::lower_bound(l.begin(), l.end(), price,
+              [](const PriceLevel& lvl, std::int64_t p){ return lvl.price < p; })
+        : std::lower_bound(l.begin(), l.end(), price,
+              [](const PriceLevel& lvl, std::int64_t p){ return lvl.price > p; });
+    if (it == l.end() || it->price != price) {
+        it = l.insert(it, PriceLevel{price, size, 0});
+    } else {
+        it->size = size;
+    }
+    record(side, *it, static_cast<std::size_t>(l.end() - it - 1));
+}
+
+void OrderBook::removeLevel(Side side, std::int64_t price) {
+    auto& l = ladder(side);
+    auto it = side == Side::Bid
+        ? std::lower_bound(l.begin(), l.end(), price,
+              [](const PriceLevel& lvl, std::int64_t p){ return lvl.price < p; })
+        : std::lower_bound(l.begin(), l.end(), price,
+              [](const PriceLevel& lvl, std::int64_t p){ return lvl.price > p; });
+    if (it == l.end() || it->price != price) return;
+    record(side, PriceLevel{price, 0, 0}, static_cast<std::size_t>(l.end() - it - 1));
+    l.erase(it);
+}
+
+void OrderBook::clear() {
+    for (Side side : {Side::Bid, Side::Ask}) {
+        auto& l = ladder(side);
+        for (std::size_t rank = 0; rank < l.size(); ++rank) {
+            record(side, PriceLevel{l[l.size() - 1 - rank].price, 0, 0}, rank);
+        }
+        l.clear();
+    }
+    orders_.clear();
+}
+
+bool OrderBook::topChanged(std::size_t n) const {
+    for (const auto& c : changes_) {
+        if (c.rank < n) return true;
+    }
+    return false;
+}
+
+OrderBook OrderBook::top(std::size_t n) const {
+    OrderBook copy;
+    for (Side side : {Side::Bid, Side::Ask}) {
+        const auto& from = ladder(side);
+        const std::size_t count = std::min(n, from.size());
+        copy.ladder(side).assign(from.end() - count, from.end());
+    }
+    return copy;
+}
+
+void OrderBook::adjust(Side side, std::int64_t price,
+                       std::int64_t dSize, std::int32_t dOrders) {
+    auto& l = ladder(side);
+    auto it = side == Side::Bid
+        ? std::lower_bound(l.begin(), l.end(), price,
+              [](const PriceLevel& lvl, std::int64_t p){ return lvl.price < p; })
+        : std::lower_bound(l.begin(), l.end(), price,
+              [](const PriceLevel& lvl, std::int64_t p){ return lvl.price > p; });
+
+    if (it == l.end() || it->price != price) {
+        if (dSize <= 0 && dOrders <= 0) return;      // removing from nothing
+        it = l.insert(it, PriceLevel{price, 0, 0});
+    }
+    it->size  += dSize;
+    it->orders = static_cast<std::uint32_t>(
+        std::max<std::int64_t>(0, static_cast<std::int64_t>(it->orders) + dOrders));
+
+    const auto rank = static_cast<std::size_t>(l.end() - it - 1);
+    if (it->size <= 0 || it->orders == 0) {
+        record(side, PriceLevel{price, 0, 0}, rank);
+        l.erase(it);
+    } else {
+        record(side, *it, rank);
+    }
+}
+
+void OrderBook::record(Side side, const PriceLevel& lvl, std::size_t rank) {
+    changes_.push_back(LevelChange{side, lvl.price, lvl.size, lvl.orders, rank});
+}
+
+void OrderBook::writeSnapshot(rapidjson::Writer<rapidjson::StringBuffer>& w,
+                              std::string_view symbol, std::size_t n,
+                              std::string_view timestamp, std::uint64_t seq) const {
+    w.StartObject();
+    w.Key("feed");   w.String("BOOK");
+    w.Key("type");   w.String("snapshot");
+    w.Key("symbol"); w.String(symbol.data(), static_cast<rapidjson::SizeType>(symbol.size()));
+    for (Side side : {Side::Bid, Side::Ask}) {
+        w.Key(side == Side::Bid ? "bids" : "asks");
+        w.StartArray();
+        const std::size_t count = std::min(n, depth(side));
+        for (std::size_t rank = 0; rank < count; ++rank) {
+            const PriceLevel& lvl = level(side, rank);
+            w.StartArray();
+            writePrice(w, lvl.price);
+            w.Int64(lvl.size);
+            w.Uint(lvl.orders);
+            w.EndArray();
+        }
+        w.EndArray();
+    }
+    if (!timestamp.empty()) {
+        w.Key("timestamp");
+        w.String(timestamp.data(), static_cast<rapidjson::SizeType>(timestamp.size()));
+    }
+    w.Key("seq");    w.Uint64(seq);
+    w.EndObject();
+}
+
+void OrderBook::writeDelta(rapidjson::Writer<rapidjson::StringBuffer>& w,
+                           std::string_view symbol,
+                           std::string_view timestamp, std::uint64_t seq) const {
+    w.StartObject();
+    w.Key("feed");   w.String("BOOK");
+    w.Key("type");   w.String("delta");
+    w.Key("symbol"); w.String(symbol.data(), static_cast<rapidjson::SizeType>(symbol.size()));
+    w.Key("changes");
+    w.StartArray();
+    for (const auto& c : changes_) {
+        w.StartArray();
+        w.String(c.side == Side::Bid ? "B" : "A");
+        writePrice(w, c.price);
+        w.Int64(c.size);
+        w.Uint(c.orders);
+        w.EndArray();
+    }
+    w.EndArray();
+    if (!timestamp.empty()) {
+        w.Key("timestamp");
+        w.String(timestamp.data(), static_cast<rapidjson::SizeType>(timestamp.size()));
+    }
+    w.Key("seq");    w.Uint64(seq);
+    w.EndObject();
+}
+
+// — OrderBookManager —
+
+static int columnOf(const Schema& schema, const char* name)
+{
+    for (std::size_t idx = 0; idx < schema.fields.size(); ++idx) {
+        if (schema.fields[idx] == name) return static_cast<int>(idx);
+    }
+    return -1;
+}
+
+OrderBookManager::OrderBookManager(const Schema& l2) {
+    bind(l2);
+}
+
+void OrderBookManager::bind(const Schema& l2) {
+    schema_       = &l2;
+    typeIdx_      = columnOf(l2, "Message Type");
+    orderIdx_     = columnOf(l2, "Order ID");
+    sideIdx_      = columnOf(l2, "Side");
+    priceIdx_     = columnOf(l2, "Price");
+    sizeIdx_      = columnOf(l2, "Order Size");
+    levelSizeIdx_ = columnOf(l2, "Level Size");
+}
+
+OrderBook* OrderBookManager::apply(const DecodedMessage& msg) {
+    if (msg.schema != schema_) bind(*msg.schema);
+    auto text = [&](int idx) {
+        return idx < 0 ? std::string_view{} : msg.fields[idx].text;
+    };
+    auto integer = [&](int idx) -> std::int64_t {
+        return (idx >= 0 && msg.fields[idx].type == FieldType::Integer)
+            ? msg.fields[idx].i : 0;
+    };
+
+    const auto type = text(typeIdx_);
+    if (type.empty() || msg.symbol == kNoSymbol) return nullptr;
+
+    const auto sideText = text(sideIdx_);
+    const OrderBook::Side side =
+        (!sideText.empty() && sideText[0] == 'A') ? OrderBook::Side::Ask
+                                                  : OrderBook::Side::Bid;
+    std::int64_t price = 0;
+    if (priceIdx_ >= 0 && msg.fields[priceIdx_].type == FieldType::Decimal) {
+        price = msg.fields[priceIdx_].i;
+    }
+    std::uint64_t orderId = 0;
+    const auto idText = text(orderIdx_);
+    const bool hasId = !idText.empty() &&
+        std::from_chars(idText.data(), idText.data() + idText.size(), orderId).ec == std::errc();
+
+    if (msg.symbol >= books_.size()) books_.resize(msg.symbol + 1);
+    auto& slot = books_[msg.symbol];
+    if (!slot) slot = std::make_unique<OrderBook>();
+    OrderBook& book = *slot;
+    book.clearChanges();
+
+    switch (type[0]) {
+    case '0':   // price level order
+    case '3':   // order add
+    case '6':   // order summary
+        if (!hasId) return nullptr;
+        book.addOrder(orderId, side, price, integer(sizeIdx_));
+        break;
+    case '4':   // order update
+        if (!hasId) return nullptr;
+        book.modifyOrder(orderId, side, price, integer(sizeIdx_));
+        break;
+    case '5':   // order delete
+        if (!hasId) return nullptr;
+        book.removeOrder(orderId);
+        break;
+    case '7':   // price level summary
+    case '8':   // price level update
+        book.setLevel(side, price, integer(levelSizeIdx_));
+        break;
+    case '9':   // price level delete
+        book.removeLevel(side, price);
+        break;
+    default:
+        return nullptr;
+    }
+    return book.changes().empty() ? nullptr : &book;
+}
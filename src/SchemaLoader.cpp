@@ -1,10 +1,11 @@
 // File: src/SchemaLoader.cpp
 #include "SchemaLoader.h"
+#include "Logger.h"
 #include <fstream>
 #include <sstream>
-#include <iostream>
 #include <algorithm>
 #include <cctype>
+#include <unordered_set>
 
 // Helper: trim whitespace and CR/LF from both ends
 static std::string trim(const std::string& s) {
@@ -13,20 +14,49 @@ static std::string trim(const std::string& s) {
     return (start == std::string::npos) ? std::string() : s.substr(start, end - start + 1);
 }
 
-// Static member definition
-std::map<std::string, std::vector<std::string>> SchemaLoader::schemas_;
+// Helper: canonicalise a field name, "Order Size" → "order-size"
+static std::string canonical(std::string s) {
+    std::replace(s.begin(), s.end(), ' ', '-');
+    std::transform(s.begin(), s.end(), s.begin(),
+                   [](unsigned char c){ return std::tolower(c); });
+    return s;
+}
+
+// Helper: field name as a quoted, escaped JSON string ("Order ID" with quotes)
+static std::string jsonQuote(const std::string& s) {
+    static const char hex[] = "0123456789abcdef";
+    std::string out = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 0xF];
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+    return out;
+}
+
+// Static member definitions
+std::map<std::string, SchemaLoader::Slot> SchemaLoader::schemas_;
+std::mutex                                SchemaLoader::mutex_;
 
 bool SchemaLoader::load(const std::string& id, const std::string& filePath) {
     std::ifstream in(filePath);
     if (!in.is_open()) {
-        std::cerr << "SchemaLoader: cannot open schema file '"
-                  << filePath << "' for id '" << id << "'\n";
+        Logger::error("SchemaLoader: cannot open schema file '",
+                      filePath, "' for id '", id, "'");
         return false;
     }
     std::string line;
     if (!std::getline(in, line)) {
-        std::cerr << "SchemaLoader: empty schema file for id '"
-                  << id << "'\n";
+        Logger::error("SchemaLoader: empty schema file for id '",
+                      id, "'");
         return false;
     }
     // Remove BOM if present
@@ -42,16 +72,72 @@ bool SchemaLoader::load(const std::string& id, const std::string& filePath) {
         fields.push_back(std::move(t));
     }
     if (fields.empty()) {
-        std::cerr << "SchemaLoader: no fields parsed for id '"
-                  << id << "'\n";
+        Logger::error("SchemaLoader: no fields parsed for id '",
+                      id, "'");
         return false;
     }
-    schemas_[id] = std::move(fields);
-    std::cout << "SchemaLoader: loaded " << schemas_[id].size()
-              << " fields for '" << id << "'\n";
+    if (fields.size() > Schema::kMaxFields) {
+        Logger::error("SchemaLoader: too many fields (", fields.size(),
+                      " > ", Schema::kMaxFields, ") for id '",
+                      id, "'");
+        return false;
+    }
+
+    std::lock_guard lock(mutex_);
+    Slot& slot = schemas_[id];
+    const Schema* old = slot.current.load(std::memory_order_relaxed);
+    if (old && old->fields == fields) return true;
+
+    slot.versions.push_back(std::make_unique<Schema>(compile(std::move(fields))));
+    const Schema* next = slot.versions.back().get();
+    slot.current.store(next, std::memory_order_release);
+    Logger::info("SchemaLoader: ", old ? "reloaded " : "loaded ", next->fields.size(),
+                 " fields for '", id, "'");
     return true;
 }
 
 const std::vector<std::string>& SchemaLoader::fields(const std::string& id) {
-    return schemas_.at(id);
+    return schema(id).fields;
+}
+
+const Schema& SchemaLoader::schema(const std::string& id) {
+    return *current(id).load(std::memory_order_acquire);
+}
+
+const std::atomic<const Schema*>& SchemaLoader::current(const std::string& id) {
+    std::lock_guard lock(mutex_);
+    return schemas_.at(id).current;
+}
+
+Schema SchemaLoader::compile(std::vector<std::string> fields) {
+    // ---- numeric field hints (lower‑case, dashes only!)
+    static const std::unordered_set<std::string> intFields = {
+        "most-recent-trade-size", "total-volume",
+        "bid-size", "ask-size", "order-size", "level-size"
+    };
+    static const std::unordered_set<std::string> decimalFields = {
+        "most-recent-trade", "bid", "ask", "open",
+        "high", "low", "close", "price"
+    };
+
+    Schema schema;
+    schema.types.reserve(fields.size());
+    schema.jsonKeys.reserve(fields.size());
+    for (std::size_t idx = 0; idx < fields.size(); ++idx) {
+        const std::string canon = canonical(fields[idx]);
+        if (intFields.count(canon))          schema.types.push_back(FieldType::Integer);
+        else if (decimalFields.count(canon)) schema.types.push_back(FieldType::Decimal);
+        else                                 schema.types.push_back(FieldType::String);
+
+        if (fields[idx] == "Date") schema.dateIndex = static_cast<int>(idx);
+        if (fields[idx] == "Time") schema.timeIndex = static_cast<int>(idx);
+        if (canon == "symbol")     schema.symbolIndex = static_cast<int>(idx);
+        if (canon == "message-type") schema.messageTypeIndex = static_cast<int>(idx);
+        schema.jsonKeys.push_back(jsonQuote(fields[idx]));
+    }
+    if (schema.dateIndex >= 0 && schema.timeIndex >= 0) {
+        schema.dateTimeMask = (1ull << schema.dateIndex) | (1ull << schema.timeIndex);
+    }
+    schema.fields = std::move(fields);
+    return schema;
 }
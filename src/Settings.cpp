@@ -0,0 +1,63 @@
+// File: src/Settings.cpp
+#include "Settings.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+// Helper: trim whitespace and CR/LF from both ends
+static std::string trim(const std::string& s) {
+    auto start = s.find_first_not_of(" \t\r\n");
+    auto end   = s.find_last_not_of(" \t\r\n");
+    return (start == std::string::npos) ? std::string() : s.substr(start, end - start + 1);
+}
+
+// Static member definition
+std::map<std::string, std::string> Settings::values_;
+
+bool Settings::load(const std::string& filePath) {
+    std::ifstream in(filePath);
+    if (!in.is_open()) {
+        Logger::warn("Settings: cannot open '", filePath,
+                     "', using defaults");
+        return false;
+    }
+    for (std::string line; std::getline(in, line); ) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        auto comma = line.find(',');
+        if (comma == std::string::npos) {
+            Logger::warn("Settings: ignoring malformed line '", line, "'");
+            continue;
+        }
+        values_[trim(line.substr(0, comma))] = trim(line.substr(comma + 1));
+    }
+    Logger::info("Settings: loaded ", values_.size(), " values");
+    return true;
+}
+
+std::string Settings::getString(const std::string& key,
+                                const std::string& def) {
+    auto it = values_.find(key);
+    return it == values_.end() ? def : it->second;
+}
+
+long long Settings::getInt(const std::string& key, long long def) {
+    auto it = values_.find(key);
+    if (it == values_.end()) return def;
+    try {
+        return std::stoll(it->second);
+    } catch (...) {
+        Logger::warn("Settings: '", key, "' is not an integer");
+        return def;
+    }
+}
+
+bool Settings::getBool(const std::string& key, bool def) {
+    auto it = values_.find(key);
+    if (it == values_.end()) return def;
+    std::string v = it->second;
+    std::transform(v.begin(), v.end(), v.begin(),
+                   [](unsigned char c){ return std::tolower(c); });
+    return v == "1" || v == "true" || v == "yes" || v == "on";
+}
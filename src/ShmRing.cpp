@@ -0,0 +1,193 @@
+// File: src/ShmRing.cpp
+#include "ShmRing.h"
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace bip = boost::interprocess;
+using namespace ShmRingFormat;
+
+namespace {
+
+constexpr std::uint64_t align16(std::uint64_t n) { return (n + 15) & ~std::uint64_t{15}; }
+
+struct RecordHeader {
+    std::uint64_t index;
+    std::uint32_t length;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(RecordHeader) == kRecordHeader, "record header layout");
+
+// Frame header written by BinaryEncoder: version, feed, type, flags,
+// u64 seq, i64 timestamp (little-endian).
+constexpr std::size_t kFrameHeader = 4 + 8 + 8;
+
+std::uint64_t getLE(const char* p) {
+    std::uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= std::uint64_t(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+} // namespace
+
+// — ShmRingWriter —
+
+ShmRingWriter::ShmRingWriter(const std::string& name, std::size_t capacity)
+  : name_(name)
+{
+    std::uint64_t cap = 4096;
+    while (cap < capacity) cap <<= 1;
+
+    bip::shared_memory_object::remove(name_.c_str());
+    shm_ = bip::shared_memory_object(bip::create_only, name_.c_str(), bip::read_write);
+    shm_.truncate(static_cast<bip::offset_t>(kDataOffset + cap));
+    region_ = bip::mapped_region(shm_, bip::read_write);
+
+    auto* base = static_cast<char*>(region_.get_address());
+    control_ = new (base) Control{};
+    control_->capacity = cap;
+    data_ = base + kDataOffset;
+    mask_ = cap - 1;
+    std::atomic_thread_fence(std::memory_order_release);
+    control_->magic = kMagic;
+}
+
+ShmRingWriter::~ShmRingWriter() {
+    control_->closed.store(1, std::memory_order_release);
+    // readers keep their mapping; new ones can no longer open the name
+    bip::shared_memory_object::remove(name_.c_str());
+}
+
+void ShmRingWriter::publish(std::string_view payload) {
+    const std::uint64_t cap  = mask_ + 1;
+    const std::uint64_t need = align16(kRecordHeader + payload.size());
+    if (need > cap / 2) return;
+
+    std::uint64_t pos = head_;
+    std::uint64_t off = pos & mask_;
+    if (off + need > cap) {
+        // not enough room before the end: pad it out and start over at 0
+        const std::uint64_t end = pos + (cap - off);
+        control_->reserve.store(end + need, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        const RecordHeader pad{index_, kPad, 0};
+        std::memcpy(data_ + off, &pad, sizeof pad);
+        pos = end;
+        off = 0;
+    } else {
+        control_->reserve.store(pos + need, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    const RecordHeader h{index_++, static_cast<std::uint32_t>(payload.size()), 0};
+    std::memcpy(data_ + off, &h, sizeof h);
+    std::memcpy(data_ + off + kRecordHeader, payload.data(), payload.size());
+    head_ = pos + need;
+    control_->commit.store(head_, std::memory_order_release);
+}
+
+void ShmRingWriter::setSchema(std::string_view json) {
+    if (json.size() > kSchemaBytes) {
+        throw std::length_error("ShmRingWriter: schema description too large");
+    }
+    const std::uint32_t v = control_->schemaVersion.load(std::memory_order_relaxed);
+    control_->schemaVersion.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(static_cast<char*>(region_.get_address()) + kSchemaOffset, json.data(), json.size());
+    control_->schemaLength = static_cast<std::uint32_t>(json.size());
+    control_->schemaVersion.store(v + 2, std::memory_order_release);
+}
+
+// — ShmRingReader —
+
+ShmRingReader::ShmRingReader(const std::string& name)
+  : shm_(bip::open_only, name.c_str(), bip::read_only),
+    region_(shm_, bip::read_only)
+{
+    const auto* base = static_cast<const char*>(region_.get_address());
+    if (region_.get_size() < kDataOffset) {
+        throw std::runtime_error("ShmRingReader: '" + name + "' is not a ring");
+    }
+    control_ = reinterpret_cast<const Control*>(base);
+    if (control_->magic != kMagic ||
+        region_.get_size() < kDataOffset + control_->capacity) {
+        throw std::runtime_error("ShmRingReader: '" + name + "' is not a ring");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    capacity_ = control_->capacity;
+    data_     = base + kDataOffset;
+    pos_      = control_->commit.load(std::memory_order_acquire);
+    buf_.reserve(capacity_ / 2);
+}
+
+bool ShmRingReader::next(Record& out) {
+    const std::uint64_t mask = capacity_ - 1;
+    for (;;) {
+        const std::uint64_t commit = control_->commit.load(std::memory_order_acquire);
+        if (pos_ == commit) return false;
+        if (commit - pos_ > capacity_) {
+            pos_ = commit;          // lapped; the index gap counts the loss
+            continue;
+        }
+
+        const std::uint64_t off = pos_ & mask;
+        RecordHeader h;
+        std::memcpy(&h, data_ + off, sizeof h);
+        const bool pad  = h.length == kPad;
+        const bool sane = pad || (h.length <= capacity_ / 2 &&
+                                  off + kRecordHeader + h.length <= capacity_);
+        if (sane && !pad) buf_.assign(data_ + off + kRecordHeader, h.length);
+
+        // everything above was copied before this check; if the writer had
+        // not reached our bytes by now, the copy is whole
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (control_->reserve.load(std::memory_order_relaxed) - pos_ > capacity_) {
+            pos_ = control_->commit.load(std::memory_order_acquire);
+            continue;
+        }
+        if (pad) {
+            pos_ += capacity_ - off;
+            continue;
+        }
+        if (!sane) {
+            pos_ = commit;          // cannot happen with an intact ring
+            continue;
+        }
+
+        if (started_ && h.index != nextIndex_) lost_ += h.index - nextIndex_;
+        started_   = true;
+        nextIndex_ = h.index + 1;
+        pos_      += align16(kRecordHeader + h.length);
+
+        out = Record{};
+        out.frame = buf_;
+        if (buf_.size() >= kFrameHeader) {
+            out.feed        = static_cast<std::uint8_t>(buf_[1]);
+            out.messageType = buf_[2];
+            out.seq         = getLE(buf_.data() + 4);
+            out.timestampNs = static_cast<std::int64_t>(getLE(buf_.data() + 12));
+        }
+        return true;
+    }
+}
+
+std::string ShmRingReader::schema() const {
+    const char* text = static_cast<const char*>(region_.get_address()) + kSchemaOffset;
+    std::string copy;
+    for (;;) {
+        const std::uint32_t v = control_->schemaVersion.load(std::memory_order_acquire);
+        if (v & 1u) continue;
+        const std::uint32_t len = control_->schemaLength;
+        if (len <= kSchemaBytes) copy.assign(text, len);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (control_->schemaVersion.load(std::memory_order_relaxed) == v) return copy;
+    }
+}
+
+std::uint32_t ShmRingReader::schemaVersion() const {
+    return control_->schemaVersion.load(std::memory_order_acquire);
+}
+
+bool ShmRingReader::closed() const {
+    return control_->closed.load(std::memory_order_acquire) != 0;
+}
@@ -0,0 +1,138 @@
+// File: src/SubscriptionManager.cpp
+#include "SubscriptionManager.h"
+#include "Logger.h"
+
+SubscriptionManager::SubscriptionManager(boost::asio::io_context& ioc,
+                                         ConnectionManager& conn,
+                                         std::string feed,
+                                         std::string subscribePrefix,
+                                         std::string unsubscribePrefix,
+                                         Options options)
+  : ioc_(ioc),
+    conn_(conn),
+    subscribePrefix_(std::move(subscribePrefix)),
+    unsubscribePrefix_(std::move(unsubscribePrefix)),
+    options_(options),
+    timer_(ioc_),
+    commands_(Metrics::counter("ingest_subscription_commands_total",
+        "Subscribe and unsubscribe commands sent to a feed", "feed=\"" + feed + "\"")),
+    active_(Metrics::gauge("ingest_subscriptions_active",
+        "Symbols subscribed on the current feed connection", "feed=\"" + feed + "\"")),
+    backlog_(Metrics::gauge("ingest_subscription_backlog",
+        "Symbols waiting for their subscription command to be sent", "feed=\"" + feed + "\""))
+{
+    if (options_.batchSize == 0) options_.batchSize = 1;
+}
+
+std::uint8_t& SubscriptionManager::state(SymbolId symbol) {
+    if (symbol >= state_.size()) state_.resize(symbol + 1, 0);
+    return state_[symbol];
+}
+
+void SubscriptionManager::subscribe(SymbolId symbol) {
+    if (symbol == kNoSymbol) return;
+    boost::asio::post(ioc_, [this, symbol] {
+        auto& s = state(symbol);
+        s = (s | kWanted) & ~kRejected;
+        enqueue(symbol);
+    });
+}
+
+void SubscriptionManager::unsubscribe(SymbolId symbol) {
+    if (symbol == kNoSymbol) return;
+    boost::asio::post(ioc_, [this, symbol] {
+        state(symbol) &= ~kWanted;
+        enqueue(symbol);
+    });
+}
+
+void SubscriptionManager::onRejected(SymbolId symbol) {
+    if (symbol == kNoSymbol) return;
+    boost::asio::post(ioc_, [this, symbol] {
+        auto& s = state(symbol);
+        if (s & kActive) active_.add(-1);
+        s = (s | kRejected) & ~kActive;
+        Logger::warn("SubscriptionManager: server rejected ", SymbolTable::name(symbol));
+    });
+}
+
+void SubscriptionManager::onConnected() {
+    boost::asio::post(ioc_, [this] {
+        connected_ = true;
+        // A new session starts with nothing; queue everything wanted.
+        std::size_t wanted = 0;
+        for (std::size_t id = 0; id < state_.size(); ++id) {
+            state_[id] &= ~kActive;
+            if ((state_[id] & kWanted) && !(state_[id] & kRejected)) {
+                enqueue(static_cast<SymbolId>(id));
+                ++wanted;
+            }
+        }
+        active_.set(0);
+        Logger::info("SubscriptionManager: subscribing ", wanted, " symbols in batches of ",
+                     options_.batchSize, " every ", options_.interval.count(), " ms");
+        schedule();
+    });
+}
+
+void SubscriptionManager::onDisconnected() {
+    boost::asio::post(ioc_, [this] {
+        connected_ = false;
+        for (auto& s : state_) s &= ~kActive;
+        active_.set(0);
+    });
+}
+
+void SubscriptionManager::enqueue(SymbolId symbol) {
+    auto& s = state(symbol);
+    if (!(s & kQueued)) {
+        s |= kQueued;
+        pending_.push_back(symbol);
+        backlog_.set(static_cast<std::int64_t>(pending_.size()));
+    }
+    schedule();
+}
+
+void SubscriptionManager::schedule() {
+    if (!connected_ || scheduled_ || pending_.empty()) return;
+    scheduled_ = true;
+    // The first batch goes out at once; later ones wait out the interval.
+    boost::asio::post(ioc_, [this] { flush(); });
+}
+
+void SubscriptionManager::flush() {
+    scheduled_ = false;
+    if (!connected_) return;
+
+    batch_.clear();
+    std::size_t sent = 0;
+    while (!pending_.empty() && sent < options_.batchSize) {
+        const SymbolId symbol = pending_.front();
+        pending_.pop_front();
+        auto& s = state_[symbol];
+        s &= ~kQueued;
+        const bool wanted = (s & kWanted) && !(s & kRejected);
+        const bool active = s & kActive;
+        if (wanted == active) continue;       // nothing to change
+
+        batch_ += wanted ? subscribePrefix_ : unsubscribePrefix_;
+        batch_ += SymbolTable::name(symbol);
+        batch_ += "\r\n";
+        s ^= kActive;
+        active_.add(wanted ? 1 : -1);
+        ++sent;
+    }
+    backlog_.set(static_cast<std::int64_t>(pending_.size()));
+    if (sent != 0) {
+        commands_.inc(sent);
+        conn_.send(batch_);
+    }
+    if (pending_.empty()) return;
+
+    scheduled_ = true;
+    timer_.expires_after(options_.interval);
+    timer_.async_wait([this](const boost::system::error_code& ec) {
+        scheduled_ = false;
+        if (!ec) schedule();
+    });
+}
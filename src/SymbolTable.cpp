@@ -0,0 +1,79 @@
+// File: src/SymbolTable.cpp
+#include "SymbolTable.h"
+#include "Logger.h"
+#include <fstream>
+#include <mutex>
+
+// Helper: trim whitespace and CR/LF from both ends
+static std::string_view trim(std::string_view s) {
+    auto start = s.find_first_not_of(" \t\r\n");
+    auto end   = s.find_last_not_of(" \t\r\n");
+    return (start == std::string_view::npos) ? std::string_view() : s.substr(start, end - start + 1);
+}
+
+// Static member definitions
+std::array<std::atomic<std::string*>, SymbolTable::kChunks> SymbolTable::chunks_{};
+std::vector<std::unique_ptr<std::string[]>>                 SymbolTable::owned_;
+std::atomic<std::size_t>                                    SymbolTable::size_{0};
+std::unordered_map<std::string_view, SymbolId>              SymbolTable::ids_;
+std::shared_mutex                                           SymbolTable::mutex_;
+
+std::vector<SymbolId> SymbolTable::load(const std::string& filePath) {
+    std::vector<SymbolId> out;
+    std::ifstream in(filePath);
+    if (!in.is_open()) {
+        Logger::error("SymbolTable: cannot open '", filePath, "'");
+        return out;
+    }
+    std::vector<bool> seen;
+    for (std::string line; std::getline(in, line); ) {
+        const auto symbol = trim(line);
+        if (symbol.empty()) continue;
+        const SymbolId id = intern(symbol);
+        if (id == kNoSymbol) break;
+        if (id >= seen.size()) seen.resize(id + 1);
+        if (!seen[id]) {
+            seen[id] = true;
+            out.push_back(id);
+        }
+    }
+    Logger::info("SymbolTable: loaded ", out.size(), " symbols from ", filePath);
+    return out;
+}
+
+SymbolId SymbolTable::find(std::string_view symbol) {
+    std::shared_lock lock(mutex_);
+    auto it = ids_.find(symbol);
+    return it == ids_.end() ? kNoSymbol : it->second;
+}
+
+SymbolId SymbolTable::intern(std::string_view symbol) {
+    if (symbol.empty()) return kNoSymbol;
+    {
+        std::shared_lock lock(mutex_);
+        auto it = ids_.find(symbol);
+        if (it != ids_.end()) return it->second;
+    }
+
+    std::unique_lock lock(mutex_);
+    auto it = ids_.find(symbol);              // lost a race with another writer
+    if (it != ids_.end()) return it->second;
+
+    const std::size_t id = size_.load(std::memory_order_relaxed);
+    if (id >= kCapacity) {
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) Logger::error("SymbolTable: full at ", kCapacity, " symbols");
+        return kNoSymbol;
+    }
+    std::string* chunk = chunks_[id >> kChunkBits].load(std::memory_order_relaxed);
+    if (!chunk) {
+        owned_.emplace_back(new std::string[kChunkMask + 1]);
+        chunk = owned_.back().get();
+        chunks_[id >> kChunkBits].store(chunk, std::memory_order_release);
+    }
+    std::string& name = chunk[id & kChunkMask];
+    name.assign(symbol.data(), symbol.size());
+    ids_.emplace(std::string_view(name), static_cast<SymbolId>(id));
+    size_.store(id + 1, std::memory_order_release);
+    return static_cast<SymbolId>(id);
+}
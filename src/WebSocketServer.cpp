@@ -1,56 +1,442 @@
 // File: src/WebSocketServer.cpp
 #include "WebSocketServer.h"
-#include <iostream>
+#include "Deflate.h"
+#include "Logger.h"
+#include <rapidjson/document.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 
-using tcp   = boost::asio::ip::tcp;
-namespace ws = boost::beast::websocket;
+using tcp    = boost::asio::ip::tcp;
+namespace ws   = boost::beast::websocket;
+namespace http = boost::beast::http;
 
-WebSocketServer::WebSocketServer(boost::asio::io_context& ioc,
-                                 unsigned short port)
-  : ioc_(ioc),
-    acceptor_{ioc_, {tcp::v4(), port}}
-{}
+static constexpr Feed kSubscribableFeeds[] = { Feed::L1, Feed::L2, Feed::Book, Feed::Bars };
+
+static std::size_t idx(Feed f) { return static_cast<std::size_t>(f); }
+
+static constexpr const char* kBinaryProtocol = "dtn.binary";
+static constexpr const char* kJsonProtocol   = "dtn.json";
+
+Feed parseFeed(std::string_view name) {
+    if (name == "L1")   return Feed::L1;
+    if (name == "L2")   return Feed::L2;
+    if (name == "BOOK") return Feed::Book;
+    if (name == "BARS") return Feed::Bars;
+    return Feed::None;
+}
+
+OverflowPolicy WebSocketServer::parsePolicy(const std::string& name) {
+    if (name == "conflate")   return OverflowPolicy::Conflate;
+    if (name == "disconnect") return OverflowPolicy::Disconnect;
+    if (name != "drop-oldest") {
+        Logger::warn("WebSocketServer: unknown overflow policy '", name,
+                     "', using drop-oldest");
+    }
+    return OverflowPolicy::DropOldest;
+}
+
+WebSocketServer::WebSocketServer(IoContextPool& pool,
+                                 unsigned short port,
+                                 Options options)
+  : pool_(pool),
+    acceptor_{pool_.at(0), {tcp::v4(), port}},
+    options_(options),
+    sessionsOpen_(Metrics::gauge("ingest_ws_sessions",
+        "Open WebSocket sessions")),
+    messagesSent_(Metrics::counter("ingest_ws_messages_sent_total",
+        "Frames written to WebSocket clients")),
+    bytesSent_(Metrics::counter("ingest_ws_bytes_sent_total",
+        "Payload bytes written to WebSocket clients")),
+    overflowDrops_(Metrics::counter("ingest_ws_overflow_drops_total",
+        "Messages dropped or conflated because a session queue was full")),
+    slowDisconnects_(Metrics::counter("ingest_ws_slow_disconnects_total",
+        "Sessions closed by the disconnect overflow policy")),
+    batchedMessages_(Metrics::counter("ingest_ws_batched_messages_total",
+        "Messages sent inside batch frames")),
+    deflateIn_(Metrics::counter("ingest_ws_deflate_input_bytes_total",
+        "Bytes of messages compressed for compressed sessions (once per message)")),
+    deflateOut_(Metrics::counter("ingest_ws_deflate_output_bytes_total",
+        "Bytes of the compressed frames produced from them")),
+    fanoutLatency_(Metrics::histogram("ingest_ws_fanout_seconds",
+        "Time to route one message and hand it to every target session (sampled)"))
+{
+    if (options_.maxQueueDepth == 0) options_.maxQueueDepth = 1;
+    // The server lives for the whole process, so the collector may keep `this`.
+    Metrics::addCollector([this](std::string& out) { renderSessionMetrics(out); });
+}
+
+void WebSocketServer::renderSessionMetrics(std::string& out) {
+    out += "# HELP ingest_ws_session_queue_depth Messages waiting in a session's outbound queue\n"
+           "# TYPE ingest_ws_session_queue_depth gauge\n";
+    std::lock_guard lock(sessionsMutex_);
+    for (const auto& s : sessions_) {
+        out += "ingest_ws_session_queue_depth{session=\"" + std::to_string(s->id) + "\"} " +
+               std::to_string(s->depth.load(std::memory_order_relaxed)) + "\n";
+    }
+}
+
+void WebSocketServer::setSnapshotProvider(SnapshotProvider provider) {
+    snapshotProvider_ = std::move(provider);
+}
+
+void WebSocketServer::setConflationProvider(ConflationProvider provider) {
+    conflationProvider_ = std::move(provider);
+}
+
+void WebSocketServer::setSchemaDescription(std::string description) {
+    auto shared = std::make_shared<const std::string>(std::move(description));
+    std::vector<std::shared_ptr<Session>> binary;
+    {
+        std::lock_guard lock(sessionsMutex_);
+        schemaDescription_ = shared;
+        for (const auto& s : sessions_) {
+            if (s->format == WireFormat::Binary) binary.push_back(s);
+        }
+    }
+    // Queued behind whatever the session already has; records encoded
+    // around the moment of a reload may still use the previous layout.
+    for (const auto& s : binary) s->send(shared, Delivery{Feed::None, 0, 0, kNoSymbol}, false);
+}
+
+WebSocketServer::SharedMessage WebSocketServer::schemaDescription() {
+    std::lock_guard lock(sessionsMutex_);
+    return schemaDescription_;
+}
 
 void WebSocketServer::start() {
     doAccept();
 }
 
-void WebSocketServer::broadcast(const std::string& message) {
-    std::cout << message << "\n";
+bool WebSocketServer::hasSubscribers(const MessageTag& tag) {
+    auto& targets = collect(tag);
+    const bool any = !targets.list.empty() || !targets.conflated.empty();
+    targets.list.clear();
+    targets.conflated.clear();
+    return any;
+}
+
+void WebSocketServer::broadcast(std::string_view message,
+                                const MessageTag& tag) {
+    auto& targets = collect(tag);
+    if (targets.list.empty() && targets.conflated.empty()) return;
+    SharedMessage text;
+    if (!targets.list.empty()) text = std::make_shared<const std::string>(message);
+    deliver(targets, text, nullptr, tag);
+}
+
+void WebSocketServer::broadcast(const SharedMessage& message,
+                                const MessageTag& tag) {
+    auto& targets = collect(tag);
+    if (targets.list.empty() && targets.conflated.empty()) return;
+    deliver(targets, message, nullptr, tag);
+}
+
+WebSocketServer::Targets& WebSocketServer::collect(const MessageTag& tag) {
+    static thread_local Targets targets;
+    targets.list.clear();
+    targets.conflated.clear();
+    targets.json = targets.binary = false;
+
+    // Conflating sessions take L1 from the cache at flush time, so they
+    // neither need this message encoded nor a copy of it queued.
+    const bool conflatable = tag.feed == Feed::L1 && tag.symbol != kNoSymbol;
+    auto add = [&](Session* s) {
+        if (conflatable && s->conflate) {
+            targets.conflated.push_back(s->shared_from_this());
+            return;
+        }
+        targets.list.push_back({s->shared_from_this(), s->format, s->compress});
+        (s->format == WireFormat::Binary ? targets.binary : targets.json) = true;
+    };
+
     std::lock_guard lock(sessionsMutex_);
+    if (tag.feed == Feed::None) {
+        for (const auto& s : sessions_) add(s.get());
+        return targets;
+    }
 
-    for (auto& session : sessions_) {
-        session->send(message);
+    const std::size_t f = idx(tag.feed);
+    auto wants = [&](Session* s) {
+        return tag.type == 0 ||
+               s->subs[f].types.test(static_cast<unsigned char>(tag.type) & 0x7F);
+    };
+    const Route& route = routes_[f];
+    for (Session* s : route.all) {
+        if (wants(s)) add(s);
     }
+    if (tag.symbol < route.bySymbol.size()) {
+        for (Session* s : route.bySymbol[tag.symbol]) {
+            if (wants(s)) add(s);
+        }
+    }
+    return targets;
+}
+
+void WebSocketServer::deliver(Targets& targets, const SharedMessage& text,
+                              const SharedMessage& binary, const MessageTag& tag) {
+    ScopedTimer timer(fanoutLatency_.sample());
+    if (text && Logger::enabled(LogLevel::Trace)) Logger::trace(*text);
+    const Delivery d{tag.feed, tag.seq, tag.conflationKey, tag.symbol};
+    // Compressed once per encoding, on first need, then shared like the rest.
+    SharedMessage deflated[2];
+    bool          tried[2] = {false, false};
+    for (auto& t : targets.list) {
+        const bool useBinary = t.format == WireFormat::Binary && binary;
+        if (t.deflate) {
+            const std::size_t k = useBinary ? 1 : 0;
+            if (!tried[k]) {
+                tried[k]   = true;
+                deflated[k] = compressed(useBinary ? *binary : *text, useBinary);
+            }
+            if (deflated[k]) {
+                t.session->send(deflated[k], d, true);
+                continue;
+            }
+        }
+        if (useBinary) t.session->send(binary, d, true);
+        else           t.session->send(text, d, false);
+    }
+    for (auto& s : targets.conflated) s->markDirty(tag.symbol);
+    targets.list.clear();
+    targets.conflated.clear();
 }
 
 void WebSocketServer::doAccept() {
-    acceptor_.async_accept(
+    // Each accepted socket is bound to the next pool context.
+    acceptor_.async_accept(pool_.next(),
         [this](boost::system::error_code ec, tcp::socket sock) {
             if (!ec) {
-                auto session = std::make_shared<Session>(std::move(sock), *this);
-                {
-                    std::lock_guard lock(sessionsMutex_);
-                    sessions_.insert(session);
-                }
-                session->start();
+                std::make_shared<Session>(std::move(sock), *this)->start();
             } else {
-                std::cerr << "WebSocketServer: accept error: " << ec.message() << "\n";
+                Logger::error("WebSocketServer: accept error: ", ec.message());
             }
             doAccept();
         });
 }
 
+void WebSocketServer::join(const std::shared_ptr<Session>& session,
+                           bool subscribeAll) {
+    std::lock_guard lock(sessionsMutex_);
+    sessions_.insert(session);
+    sessionsOpen_.add(1);
+    if (!subscribeAll) return;
+    for (Feed feed : kSubscribableFeeds) {
+        Subscription& sub = session->subs[idx(feed)];
+        sub.all = true;
+        sub.types.set();
+        routes_[idx(feed)].all.push_back(session.get());
+    }
+}
+
+void WebSocketServer::leave(const std::shared_ptr<Session>& session) {
+    std::lock_guard lock(sessionsMutex_);
+    if (!sessions_.erase(session)) return;
+    sessionsOpen_.add(-1);
+    for (Feed feed : kSubscribableFeeds) {
+        Subscription& sub = session->subs[idx(feed)];
+        if (sub.all) {
+            auto& all = routes_[idx(feed)].all;
+            all.erase(std::remove(all.begin(), all.end(), session.get()), all.end());
+        }
+        for (const auto& sym : sub.symbols) indexRemove(session.get(), feed, sym);
+        sub = Subscription{};
+    }
+}
+
+std::vector<std::pair<Feed, SymbolId>>
+WebSocketServer::updateSubscription(const std::shared_ptr<Session>& session, bool add,
+                                    const std::vector<Feed>& feeds,
+                                    const std::vector<SymbolId>& symbols,
+                                    const std::string& types) {
+    std::vector<std::pair<Feed, SymbolId>> added;
+    const bool wholeFeed = symbols.empty();
+
+    std::lock_guard lock(sessionsMutex_);
+    if (!sessions_.count(session)) return added;
+
+    for (Feed feed : feeds) {
+        Subscription& sub = session->subs[idx(feed)];
+        Route& route      = routes_[idx(feed)];
+        const bool wasSubscribed = sub.all || !sub.symbols.empty();
+
+        if (add) {
+            if (!types.empty()) {
+                sub.types.reset();
+                for (char c : types) sub.types.set(static_cast<unsigned char>(c) & 0x7F);
+            } else if (!wasSubscribed) {
+                sub.types.set();
+            }
+            if (sub.all) continue;                       // already has everything
+            if (wholeFeed) {
+                for (const auto& sym : sub.symbols) indexRemove(session.get(), feed, sym);
+                sub.symbols.clear();
+                sub.all = true;
+                route.all.push_back(session.get());
+                added.emplace_back(feed, kNoSymbol);
+            } else {
+                for (const auto& sym : symbols) {
+                    if (sub.symbols.insert(sym).second) {
+                        indexAdd(session.get(), feed, sym);
+                        added.emplace_back(feed, sym);
+                    }
+                }
+            }
+        } else if (wholeFeed) {
+            if (sub.all) {
+                route.all.erase(std::remove(route.all.begin(), route.all.end(), session.get()),
+                                route.all.end());
+            }
+            for (const auto& sym : sub.symbols) indexRemove(session.get(), feed, sym);
+            sub = Subscription{};
+        } else {
+            for (const auto& sym : symbols) {
+                if (sub.symbols.erase(sym)) indexRemove(session.get(), feed, sym);
+            }
+        }
+    }
+    return added;
+}
+
+void WebSocketServer::setFormat(const std::shared_ptr<Session>& session,
+                                WireFormat format) {
+    std::lock_guard lock(sessionsMutex_);
+    session->format = format;
+}
+
+void WebSocketServer::setConflation(const std::shared_ptr<Session>& session, bool on) {
+    std::lock_guard lock(sessionsMutex_);
+    session->conflate = on;
+}
+
+void WebSocketServer::setCompression(const std::shared_ptr<Session>& session, bool on) {
+    std::lock_guard lock(sessionsMutex_);
+    session->compress = on;
+}
+
+SymbolId WebSocketServer::clientSymbol(std::string_view name) {
+    static constexpr std::size_t kMaxSymbolChars = 32;
+    if (const SymbolId id = SymbolTable::find(name); id != kNoSymbol) return id;
+    if (name.empty() || name.size() > kMaxSymbolChars) return kNoSymbol;
+    if (clientSymbols_.fetch_add(1, std::memory_order_relaxed) >= options_.maxClientSymbols) {
+        clientSymbols_.fetch_sub(1, std::memory_order_relaxed);
+        return kNoSymbol;
+    }
+    const std::size_t before = SymbolTable::size();
+    const SymbolId id = SymbolTable::intern(name);
+    // a feed or another client got there first: no new id was spent
+    if (id == kNoSymbol || id < before) clientSymbols_.fetch_sub(1, std::memory_order_relaxed);
+    return id;
+}
+
+WebSocketServer::SharedMessage
+WebSocketServer::compressed(const std::string& msg, bool binary) {
+    if (msg.size() < options_.compressMinBytes) return nullptr;
+    static thread_local std::string scratch;
+    if (!Deflate::compress(msg, binary, options_.compressLevel, scratch)) return nullptr;
+    deflateIn_.inc(msg.size());
+    deflateOut_.inc(scratch.size());
+    return std::make_shared<const std::string>(scratch);
+}
+
+WebSocketServer::SharedMessage
+WebSocketServer::conflatedL1(SymbolId symbol, WireFormat format, bool deflate,
+                             std::uint64_t& seq, bool& binaryFrame) {
+    const std::size_t f = static_cast<std::size_t>(format);
+    binaryFrame = format == WireFormat::Binary;
+    Rendered cached, cachedDeflated;
+    {
+        std::lock_guard lock(conflatedMutex_);
+        if (symbol >= conflated_.size()) conflated_.resize(symbol + 1);
+        cached         = conflated_[symbol][f];
+        cachedDeflated = conflated_[symbol][2 + f];
+    }
+    // Render outside the lock; the provider skips the work if nothing changed.
+    static thread_local std::string scratch;
+    seq = conflationProvider_(symbol, format, cached.seq, scratch);
+    if (seq == 0) return nullptr;
+
+    SharedMessage message = cached.message;
+    if (seq != cached.seq) {
+        message = std::make_shared<const std::string>(scratch);
+        std::lock_guard lock(conflatedMutex_);
+        Rendered& slot = conflated_[symbol][f];
+        if (seq > slot.seq) slot = Rendered{seq, message};
+    }
+    if (!deflate) return message;
+
+    // The compressed form is cached beside the plain one, so it too is
+    // produced once per update.
+    if (cachedDeflated.seq == seq && cachedDeflated.message) {
+        binaryFrame = true;
+        return cachedDeflated.message;
+    }
+    auto z = compressed(*message, format == WireFormat::Binary);
+    if (!z) return message;
+    std::lock_guard lock(conflatedMutex_);
+    Rendered& slot = conflated_[symbol][2 + f];
+    if (seq > slot.seq) slot = Rendered{seq, z};
+    binaryFrame = true;
+    return z;
+}
+
+void WebSocketServer::indexAdd(Session* s, Feed feed, SymbolId symbol) {
+    auto& bySymbol = routes_[idx(feed)].bySymbol;
+    if (symbol >= bySymbol.size()) bySymbol.resize(symbol + 1);
+    bySymbol[symbol].push_back(s);
+}
+
+void WebSocketServer::indexRemove(Session* s, Feed feed, SymbolId symbol) {
+    auto& bySymbol = routes_[idx(feed)].bySymbol;
+    if (symbol >= bySymbol.size()) return;
+    auto& v = bySymbol[symbol];
+    v.erase(std::remove(v.begin(), v.end(), s), v.end());
+}
+
 // — Session —
 
 WebSocketServer::Session::Session(tcp::socket socket,
                                   WebSocketServer& parent)
-  : parent_(parent),
-    ws_(std::move(socket))
+  : id(parent.nextSessionId_.fetch_add(1, std::memory_order_relaxed)),
+    parent_(parent),
+    ws_(std::move(socket)),
+    conflateTimer_(ws_.get_executor()),
+    batchTimer_(ws_.get_executor()),
+    batchUs_(parent.options_.batchWindowUs),
+    batchBytes_(std::max<std::size_t>(1, parent.options_.batchBytes))
 {}
 
 void WebSocketServer::Session::start() {
-    ws_.async_accept(
+    // Read the upgrade request ourselves so its URL can carry options.
+    http::async_read(ws_.next_layer(), readBuffer_, request_,
+        [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
+            self->onRequest(ec);
+        });
+}
+
+void WebSocketServer::Session::onRequest(boost::beast::error_code ec) {
+    if (ec || !ws::is_upgrade(request_)) {
+        Logger::warn("Session: bad upgrade request",
+                     ec ? ": " + ec.message() : std::string());
+        close();
+        return;
+    }
+    // Pick binary if the client offers our subprotocol; echo what we chose.
+    const auto offered = request_[http::field::sec_websocket_protocol];
+    const char* chosen = nullptr;
+    if (offered.find(kBinaryProtocol) != boost::beast::string_view::npos) {
+        format = WireFormat::Binary;
+        chosen = kBinaryProtocol;
+    } else if (offered.find(kJsonProtocol) != boost::beast::string_view::npos) {
+        chosen = kJsonProtocol;
+    }
+    if (chosen) {
+        ws_.set_option(ws::stream_base::decorator(
+            [chosen](ws::response_type& res) {
+                res.set(http::field::sec_websocket_protocol, chosen);
+            }));
+    }
+    ws_.async_accept(request_,
         [self = shared_from_this()](boost::beast::error_code ec) {
             self->onAccept(ec);
         });
@@ -58,22 +444,492 @@ void WebSocketServer::Session::start() {
 
 void WebSocketServer::Session::onAccept(boost::beast::error_code ec) {
     if (!ec) {
-        std::cout << "Session: client connected\n";
+        Logger::info("Session: client connected");
+        open_ = true;
+        const bool subscribeAll =
+            request_.target().find("subscribe=none") == boost::beast::string_view::npos;
+        request_ = {};
+        if (parent_.options_.l1ConflationMs >= 0 && parent_.conflationProvider_) {
+            setConflation(parent_.options_.l1ConflationMs);
+        }
+        if (parent_.options_.compress) setCompression(true);
+        // Join first, then snapshot: live messages posted in between queue
+        // up behind this handler and are filtered by the snapshot's seq.
+        parent_.join(shared_from_this(), subscribeAll);
+        if (format == WireFormat::Binary) {
+            if (auto desc = parent_.schemaDescription()) reply(*desc);
+        }
+        if (subscribeAll) {
+            std::vector<std::pair<Feed, SymbolId>> everything;
+            for (Feed feed : kSubscribableFeeds) everything.emplace_back(feed, kNoSymbol);
+            sendSnapshot([](Feed, SymbolId) { return true; }, everything);
+        }
+        doRead();
+        kick();
     } else {
-        std::cerr << "Session: accept handshake error: " << ec.message() << "\n";
+        Logger::warn("Session: accept handshake error: ", ec.message());
+        close();
     }
 }
 
-void WebSocketServer::Session::send(const std::string& msg) {
-    std::lock_guard lock(writeMutex_);
-    ws_.async_write(boost::asio::buffer(msg),
-        [self = shared_from_this()](boost::beast::error_code ec, std::size_t) {
-            self->onWrite(ec, 0);
+void WebSocketServer::Session::doRead() {
+    ws_.async_read(readBuffer_,
+        [self = shared_from_this()](boost::beast::error_code ec, std::size_t n) {
+            self->onRead(ec, n);
         });
 }
 
-void WebSocketServer::Session::onWrite(boost::beast::error_code ec, std::size_t) {
+void WebSocketServer::Session::onRead(boost::beast::error_code ec, std::size_t) {
+    if (closed_) return;
     if (ec) {
-        std::cerr << "Session: write error: " << ec.message() << "\n";
+        if (ec != ws::error::closed) {
+            Logger::warn("Session: read error: ", ec.message());
+        }
+        close();
+        return;
+    }
+    const std::string text = boost::beast::buffers_to_string(readBuffer_.data());
+    readBuffer_.consume(readBuffer_.size());
+    handleCommand(text);
+    doRead();
+}
+
+void WebSocketServer::Session::handleCommand(std::string_view text) {
+    rapidjson::Document doc;
+    doc.Parse(text.data(), text.size());
+    if (doc.HasParseError() || !doc.IsObject() ||
+        !doc.HasMember("op") || !doc["op"].IsString()) {
+        reply(R"({"feed":"SYSTEM","type":"error","message":"expected {\"op\":...}"})");
+        return;
+    }
+    const std::string op = doc["op"].GetString();
+    if (op == "format") {
+        const std::string value = doc.HasMember("value") && doc["value"].IsString()
+                                ? doc["value"].GetString() : "";
+        if (value != "json" && value != "binary") {
+            reply(R"({"feed":"SYSTEM","type":"error","message":"format must be json or binary"})");
+            return;
+        }
+        reply(R"({"feed":"SYSTEM","type":"ack","op":"format","value":")" + value + R"("})");
+        setFormat(value == "binary" ? WireFormat::Binary : WireFormat::Json);
+        return;
+    }
+    if (op == "conflate") {
+        const bool on = !doc.HasMember("value") || !doc["value"].IsBool() || doc["value"].GetBool();
+        const int interval = doc.HasMember("interval") && doc["interval"].IsInt()
+                           ? std::max(0, doc["interval"].GetInt()) : 0;
+        if (on && !parent_.conflationProvider_) {
+            reply(R"({"feed":"SYSTEM","type":"error","message":"conflation not available"})");
+            return;
+        }
+        reply(R"({"feed":"SYSTEM","type":"ack","op":"conflate","value":)" +
+              std::string(on ? "true" : "false") + R"(,"interval":)" +
+              std::to_string(on ? interval : 0) + "}");
+        setConflation(on ? interval : -1);
+        return;
+    }
+    if (op == "compress") {
+        const bool on = !doc.HasMember("value") || !doc["value"].IsBool() || doc["value"].GetBool();
+        reply(R"({"feed":"SYSTEM","type":"ack","op":"compress","value":)" +
+              std::string(on ? "true" : "false") + "}");
+        setCompression(on);
+        return;
+    }
+    if (op == "batch") {
+        const bool on = !doc.HasMember("value") || !doc["value"].IsBool() || doc["value"].GetBool();
+        // Longest window a client may ask for, in ms.
+        static constexpr double kMaxBatchWindowMs = 60000.0;
+        double windowMs = doc.HasMember("window") && doc["window"].IsNumber()
+                        ? doc["window"].GetDouble() : 0.0;
+        if (!std::isfinite(windowMs)) {
+            reply(R"({"feed":"SYSTEM","type":"error","message":"window must be a finite number"})");
+            return;
+        }
+        windowMs = std::clamp(windowMs, 0.0, kMaxBatchWindowMs);
+        const std::size_t bytes = doc.HasMember("bytes") && doc["bytes"].IsUint()
+                                ? std::max(1u, doc["bytes"].GetUint()) : parent_.options_.batchBytes;
+        char window[32];
+        std::snprintf(window, sizeof window, "%g", on ? windowMs : 0.0);
+        reply(R"({"feed":"SYSTEM","type":"ack","op":"batch","value":)" +
+              std::string(on ? "true" : "false") + R"(,"window":)" + window +
+              R"(,"bytes":)" + std::to_string(bytes) + "}");
+        setBatching(on ? static_cast<std::int64_t>(windowMs * 1000.0) : -1, bytes);
+        return;
+    }
+    if (op != "subscribe" && op != "unsubscribe") {
+        reply(R"({"feed":"SYSTEM","type":"error","message":"unknown op"})");
+        return;
+    }
+
+    // "feed"/"symbols"/"types" accept a string or an array of strings.
+    auto strings = [&](const char* key) {
+        std::vector<std::string> out;
+        if (!doc.HasMember(key)) return out;
+        const auto& v = doc[key];
+        if (v.IsString()) {
+            out.emplace_back(v.GetString(), v.GetStringLength());
+        } else if (v.IsArray()) {
+            for (auto e = v.Begin(); e != v.End(); ++e) {
+                if (e->IsString()) out.emplace_back(e->GetString(), e->GetStringLength());
+            }
+        }
+        return out;
+    };
+
+    std::vector<Feed> feeds;
+    for (const auto& name : strings("feed")) {
+        if (name == "*") { feeds.clear(); break; }
+        const Feed f = parseFeed(name);
+        if (f == Feed::None) {
+            reply(R"({"feed":"SYSTEM","type":"error","message":"unknown feed"})");
+            return;
+        }
+        feeds.push_back(f);
+    }
+    if (feeds.empty()) feeds.assign(std::begin(kSubscribableFeeds), std::end(kSubscribableFeeds));
+
+    std::string types;
+    for (const auto& t : strings("types")) {
+        if (!t.empty()) types.push_back(t[0]);
+    }
+
+    // A subscription may name a symbol before it first appears on a feed,
+    // within the server's budget for client-created ids; "*" means the
+    // whole feed. Unsubscribing never creates ids.
+    const bool subscribe = op == "subscribe";
+    std::vector<SymbolId> symbols;
+    bool named = false;
+    for (const auto& name : strings("symbols")) {
+        if (name == "*") { symbols.clear(); named = false; break; }
+        named = true;
+        const SymbolId id = subscribe ? parent_.clientSymbol(name) : SymbolTable::find(name);
+        if (id != kNoSymbol) {
+            symbols.push_back(id);
+        } else if (subscribe) {
+            reply(R"({"feed":"SYSTEM","type":"error","message":"too many unknown symbols"})");
+            return;
+        }
+    }
+    if (named && symbols.empty()) {
+        // none of them was ever subscribable; empty would mean the whole feed
+        reply(R"({"feed":"SYSTEM","type":"ack","op":")" + op + R"("})");
+        return;
+    }
+
+    const std::size_t history = doc.HasMember("history") && doc["history"].IsUint()
+                              ? doc["history"].GetUint() : 1;
+
+    const auto added = parent_.updateSubscription(
+        shared_from_this(), subscribe, feeds, symbols, types);
+
+    reply(R"({"feed":"SYSTEM","type":"ack","op":")" + op + R"("})");
+    if (!added.empty()) {
+        sendSnapshot(
+            [&added](Feed feed, SymbolId symbol) {
+                for (const auto& [f, sym] : added) {
+                    if (f == feed && (sym == kNoSymbol || sym == symbol)) return true;
+                }
+                return false;
+            },
+            added, history);
+    }
+}
+
+void WebSocketServer::Session::sendSnapshot(
+        const SnapshotFilter& filter,
+        const std::vector<std::pair<Feed, SymbolId>>& added,
+        std::size_t barHistory) {
+    if (!parent_.snapshotProvider_) return;
+    Snapshot snap;
+    snap.format     = format;
+    snap.barHistory = barHistory;
+    parent_.snapshotProvider_(filter, snap);
+
+    // Live messages the snapshot already reflects must not be sent again.
+    for (const auto& [feed, sym] : added) {
+        const std::uint64_t seq = snap.seq[idx(feed)];
+        if (sym == kNoSymbol) floor_[idx(feed)] = std::max(floor_[idx(feed)], seq);
+        else                  symbolFloor_[idx(feed)][sym] = seq;
+    }
+    // The snapshot is queued whole; the depth limit applies to live data.
+    for (auto& m : snap.messages) {
+        push(Outbound{std::make_shared<const std::string>(std::move(m.data)), 0, m.binary});
+    }
+    noteDepth();
+    kick();
+}
+
+void WebSocketServer::Session::reply(std::string msg) {
+    if (closed_) return;
+    push(Outbound{std::make_shared<const std::string>(std::move(msg)), 0, false});
+    noteDepth();
+    kick();
+}
+
+void WebSocketServer::Session::setFormat(WireFormat f) {
+    if (f == format) return;
+    // Binary clients need the layout before the first record.
+    if (f == WireFormat::Binary) {
+        if (auto desc = parent_.schemaDescription()) reply(*desc);
+    }
+    parent_.setFormat(shared_from_this(), f);
+}
+
+void WebSocketServer::Session::setConflation(int intervalMs) {
+    const int was = conflateMs_.exchange(intervalMs);
+    parent_.setConflation(shared_from_this(), intervalMs >= 0);
+    if (was > 0) conflateTimer_.cancel();
+    if (intervalMs > 0) armConflationTimer();
+    // Symbols left dirty when turning conflation off go out now; turning it
+    // on drains anything pending once the socket is free.
+    flushDirty();
+}
+
+void WebSocketServer::Session::setCompression(bool on) {
+    parent_.setCompression(shared_from_this(), on);
+}
+
+void WebSocketServer::Session::armConflationTimer() {
+    conflateTimer_.expires_after(std::chrono::milliseconds(conflateMs_.load()));
+    conflateTimer_.async_wait(
+        [self = shared_from_this()](boost::beast::error_code ec) {
+            if (ec || self->closed_ || self->conflateMs_.load() <= 0) return;
+            self->flushDirty();
+            self->armConflationTimer();
+        });
+}
+
+void WebSocketServer::Session::setBatching(std::int64_t windowUs, std::size_t bytes) {
+    batchUs_    = windowUs;
+    batchBytes_ = bytes;
+    // a shorter window may already have expired
+    batchDeadline_ = std::chrono::steady_clock::now();
+    batchTimer_.cancel();
+    kick();
+}
+
+void WebSocketServer::Session::armBatchTimer() {
+    if (batchArmed_) return;
+    batchArmed_ = true;
+    batchTimer_.expires_at(batchDeadline_);
+    batchTimer_.async_wait(
+        [self = shared_from_this()](boost::beast::error_code) {
+            self->batchArmed_ = false;
+            if (!self->closed_) self->kick();
+        });
+}
+
+void WebSocketServer::Session::markDirty(SymbolId symbol) {
+    bool wake;
+    {
+        std::lock_guard lock(dirtyMutex_);
+        if (symbol >= isDirty_.size()) isDirty_.resize(symbol + 1);
+        if (isDirty_[symbol]) return;   // already pending
+        isDirty_[symbol] = true;
+        dirty_.push_back(symbol);
+        wake = dirty_.size() == 1;
+    }
+    // Timed sessions wait for their tick; the others flush as soon as the
+    // session thread sees the socket free.
+    if (wake && conflateMs_.load(std::memory_order_relaxed) == 0) {
+        boost::asio::post(ws_.get_executor(),
+            [self = shared_from_this()] { self->flushDirty(); });
+    }
+}
+
+void WebSocketServer::Session::flushDirty() {
+    if (closed_ || !open_) return;
+    // In writable mode a write in flight means the socket is busy; onWrite
+    // flushes once the queue drains, by which time more updates may have
+    // merged into the same records.
+    if (conflateMs_.load() == 0 && writing_) return;
+    {
+        std::lock_guard lock(dirtyMutex_);
+        if (dirty_.empty()) return;
+        flushing_.swap(dirty_);
+        for (SymbolId symbol : flushing_) isDirty_[symbol] = false;
+    }
+    for (SymbolId symbol : flushing_) {
+        std::uint64_t seq = 0;
+        bool binaryFrame = false;
+        auto msg = parent_.conflatedL1(symbol, format, compress, seq, binaryFrame);
+        if (!msg) continue;
+        enqueue(std::move(msg), Delivery{Feed::L1, seq, conflationKey(Feed::L1, symbol), symbol},
+                binaryFrame);
+    }
+    flushing_.clear();
+}
+
+void WebSocketServer::Session::send(SharedMessage msg, const Delivery& d, bool binary) {
+    // Hop onto the session's executor; the queue is only touched there.
+    boost::asio::post(ws_.get_executor(),
+        [self = shared_from_this(), msg = std::move(msg), d, binary]() mutable {
+            self->enqueue(std::move(msg), d, binary);
+        });
+}
+
+void WebSocketServer::Session::enqueue(SharedMessage msg, const Delivery& d, bool binary) {
+    if (closed_) return;
+    if (d.seq != 0) {
+        const std::size_t f = idx(d.feed);
+        if (d.seq <= floor_[f]) return;     // already in this session's snapshot
+        auto& floors = symbolFloor_[f];
+        if (!floors.empty()) {
+            auto it = floors.find(d.symbol);
+            if (it != floors.end()) {
+                if (d.seq <= it->second) return;
+                floors.erase(it);           // later seqs only grow
+            }
+        }
+    }
+    const std::size_t key = d.conflationKey;
+
+    const Options& opts = parent_.options_;
+    if (queue_.size() >= opts.maxQueueDepth) {
+        // The front entry may be in flight and must stay put.
+        const std::size_t first = writing_ && !batchWriting_ ? 1 : 0;
+
+        switch (opts.overflowPolicy) {
+        case OverflowPolicy::Disconnect:
+            Logger::warn("Session: queue limit ", opts.maxQueueDepth,
+                         " reached, disconnecting slow client");
+            parent_.slowDisconnects_.inc();
+            close();
+            return;
+
+        case OverflowPolicy::Conflate:
+            if (key != 0) {
+                for (std::size_t i = first; i < queue_.size(); ++i) {
+                    if (queue_[i].key == key) {
+                        queuedBytes_ += msg->size() - queue_[i].payload->size();
+                        queue_[i].payload = std::move(msg);
+                        queue_[i].binary  = binary;
+                        ++dropped_;
+                        parent_.overflowDrops_.inc();
+                        return;
+                    }
+                }
+            }
+            [[fallthrough]];   // nothing to conflate with: shed the oldest
+
+        case OverflowPolicy::DropOldest:
+            if (queue_.size() > first) {
+                queuedBytes_ -= queue_[first].payload->size();
+                queue_.erase(queue_.begin() + first);
+            }
+            parent_.overflowDrops_.inc();
+            if (dropped_++ == 0) {
+                Logger::warn("Session: queue limit ", opts.maxQueueDepth,
+                             " reached, dropping messages");
+            }
+            break;
+        }
+    }
+
+    push(Outbound{std::move(msg), key, binary});
+    noteDepth();
+    kick();
+}
+
+void WebSocketServer::Session::push(Outbound out) {
+    if (queue_.empty() && batchUs_ > 0) {
+        batchDeadline_ = std::chrono::steady_clock::now() + std::chrono::microseconds(batchUs_);
+    }
+    queuedBytes_ += out.payload->size();
+    queue_.push_back(std::move(out));
+}
+
+void WebSocketServer::Session::kick() {
+    if (!open_ || writing_ || queue_.empty()) return;
+    // Hold a partial batch until its oldest message is due.
+    if (batchUs_ > 0 && queuedBytes_ < batchBytes_ &&
+        std::chrono::steady_clock::now() < batchDeadline_) {
+        armBatchTimer();
+        return;
+    }
+    doWrite();
+}
+
+void WebSocketServer::Session::doWrite() {
+    writing_ = true;
+    batchWriting_ = batchUs_ >= 0;
+    if (!batchWriting_) {
+        // The queued pointer keeps the payload alive until the write completes.
+        ws_.binary(queue_.front().binary);
+        ws_.async_write(boost::asio::buffer(*queue_.front().payload),
+            [self = shared_from_this()](boost::beast::error_code ec, std::size_t n) {
+                self->onWrite(ec, n);
+            });
+        return;
+    }
+
+    // Coalesce the leading run of same-kind messages, up to batchBytes_.
+    const bool binary = queue_.front().binary;
+    batch_.clear();
+    batch_.push_back(binary ? static_cast<char>(kBatchMarker) : '[');
+    batchCount_ = 0;
+    while (!queue_.empty() && queue_.front().binary == binary) {
+        const std::string& m = *queue_.front().payload;
+        if (batchCount_ != 0 && batch_.size() + m.size() + 4 > batchBytes_) break;
+        if (binary) {
+            const auto n = static_cast<std::uint32_t>(m.size());
+            const char len[4] = {static_cast<char>(n), static_cast<char>(n >> 8),
+                                 static_cast<char>(n >> 16), static_cast<char>(n >> 24)};
+            batch_.append(len, 4);
+        } else if (batchCount_ != 0) {
+            batch_.push_back(',');
+        }
+        batch_.append(m);
+        queuedBytes_ -= m.size();
+        queue_.pop_front();
+        ++batchCount_;
+    }
+    if (!binary) batch_.push_back(']');
+    // whatever is left has waited long enough already
+    batchDeadline_ = std::chrono::steady_clock::now();
+    noteDepth();
+
+    ws_.binary(binary);
+    ws_.async_write(boost::asio::buffer(batch_),
+        [self = shared_from_this()](boost::beast::error_code ec, std::size_t n) {
+            self->onWrite(ec, n);
+        });
+}
+
+void WebSocketServer::Session::onWrite(boost::beast::error_code ec, std::size_t n) {
+    writing_ = false;
+    if (closed_) return;
+    if (ec) {
+        Logger::warn("Session: write error: ", ec.message());
+        close();
+        return;
+    }
+    parent_.messagesSent_.inc();
+    parent_.bytesSent_.inc(n);
+    if (batchWriting_) {
+        parent_.batchedMessages_.inc(batchCount_);
+    } else {
+        queuedBytes_ -= queue_.front().payload->size();
+        queue_.pop_front();
+    }
+    noteDepth();
+    if (!queue_.empty()) kick();
+    else if (conflateMs_.load(std::memory_order_relaxed) == 0) flushDirty();
+}
+
+void WebSocketServer::Session::close() {
+    if (closed_) return;
+    closed_ = true;
+    open_   = false;
+    queue_.clear();
+    queuedBytes_ = 0;
+    noteDepth();
+    conflateTimer_.cancel();
+    batchTimer_.cancel();
+    if (dropped_ != 0) {
+        Logger::warn("Session: closed after dropping ", dropped_, " messages");
     }
+    boost::beast::error_code ec;
+    ws_.next_layer().close(ec);   // aborts any write still in flight
+    parent_.leave(shared_from_this());
 }
@@ -1,29 +1,119 @@
 // File: src/main.cpp
+#include "BarAggregator.h"
 #include "SchemaLoader.h"
+#include "ShmRing.h"
+#include "SymbolTable.h"
+#include "Settings.h"
+#include "SubscriptionManager.h"
+#include "Logger.h"
 #include "MessageDecoder.h"
+#include "BinaryEncoder.h"
+#include "ConfigWatcher.h"
+#include "LastValueCache.h"
 #include "ConnectionManager.h"
+#include "FeedJournal.h"
+#include "IoContextPool.h"
+#include "Metrics.h"
+#include "MetricsServer.h"
 #include "WebSocketServer.h"
 #include <rapidjson/writer.h>
 #include <rapidjson/stringbuffer.h>
 #include <boost/asio.hpp>
 #include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
 #include <filesystem>
-#include <fstream>
-#include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <thread>
 
-static thread_local rapidjson::Document     _reuseDoc;
+// Per-thread decode/serialize scratch. Messages are written straight into
+// a reused buffer, so the hot path stays off the heap.
+static thread_local DecodedMessage          _reuseMsg;
 static thread_local rapidjson::StringBuffer _reuseSb;
 static thread_local rapidjson::Writer<rapidjson::StringBuffer> _reuseWriter{_reuseSb};
+static thread_local std::string             _reuseBin;
 
-static std::string trim(const std::string& s) {
+static std::string_view trimView(std::string_view s) {
     const auto ws = " \t\r\n";
     auto l = s.find_first_not_of(ws);
     auto r = s.find_last_not_of(ws);
-    return (l == std::string::npos) ? std::string{} : s.substr(l, r - l + 1);
+    return (l == std::string_view::npos) ? std::string_view{} : s.substr(l, r - l + 1);
 }
 
+/// Serialize a decoded message in the feed's JSON shape into _reuseSb.
+/// The schema's own "Message Type" column is dropped in favour of the
+/// top-level messageType tag.
+static std::string_view serialize(const DecodedMessage& msg, const char* feed,
+                                  std::string_view messageType, std::uint64_t seq,
+                                  bool snapshot = false) {
+    _reuseSb.Clear();
+    _reuseWriter.Reset(_reuseSb);
+    _reuseWriter.StartObject();
+    MessageDecoder::writeFields(msg, _reuseWriter);
+    _reuseWriter.Key("feed");
+    _reuseWriter.String(feed);
+    _reuseWriter.Key("messageType");
+    _reuseWriter.String(messageType.data(), static_cast<rapidjson::SizeType>(messageType.size()));
+    _reuseWriter.Key("seq");
+    _reuseWriter.Uint64(seq);
+    if (snapshot) {
+        _reuseWriter.Key("snapshot");
+        _reuseWriter.Bool(true);
+    }
+    _reuseWriter.EndObject();
+    return std::string_view(_reuseSb.GetString(), _reuseSb.GetSize());
+}
+
+/// Encode a decoded message for binary sessions into _reuseBin.
+static std::string_view encodeBinary(const DecodedMessage& msg, Feed feed,
+                                     char messageType, std::uint64_t seq,
+                                     bool snapshot = false) {
+    BinaryEncoder::encode(msg, static_cast<std::uint8_t>(feed), messageType,
+                          seq, snapshot, _reuseBin);
+    return _reuseBin;
+}
+
+/// Conflation key for feed's stream of the last decoded message's symbol
+/// (0 = none).
+static std::size_t symbolKey(Feed feed) {
+    return _reuseMsg.symbol == kNoSymbol ? 0 : conflationKey(feed, _reuseMsg.symbol);
+}
+
+/// Data-path counters for one feed, labelled feed="L1"/"L2".
+struct FeedMetrics {
+    Counter&   decoded;
+    Counter&   skipped;        ///< control/unsubscribed rows never decoded
+    Counter&   decodeErrors;
+    Histogram& decode;
+
+    explicit FeedMetrics(const std::string& feed)
+      : decoded(Metrics::counter("ingest_decoded_total",
+            "Feed rows decoded", "feed=\"" + feed + "\"")),
+        skipped(Metrics::counter("ingest_skipped_lines_total",
+            "Feed lines ignored before decode", "feed=\"" + feed + "\"")),
+        decodeErrors(Metrics::counter("ingest_decode_errors_total",
+            "Feed rows that failed to decode", "feed=\"" + feed + "\"")),
+        decode(Metrics::histogram("ingest_decode_seconds",
+            "Time to decode one feed row (sampled)", "feed=\"" + feed + "\"")) {}
+};
+
+/// One L2 depth connection and the subscriptions for the symbols routed
+/// to it.
+struct L2Shard {
+    ConnectionManager   conn;
+    SubscriptionManager subs;
+
+    L2Shard(boost::asio::io_context& ioc, std::size_t index,
+            const SubscriptionManager::Options& options)
+      : conn(ioc, "127.0.0.1", 9200),
+        subs(ioc, conn, "L2/" + std::to_string(index), "WOR,", "ROR,", options) {}
+};
+
 static std::filesystem::path getConfigDir() {
     wchar_t buf[MAX_PATH];
     const DWORD len = GetModuleFileNameW(NULL, buf, MAX_PATH);
@@ -31,101 +121,509 @@ static std::filesystem::path getConfigDir() {
     return std::filesystem::path(buf).parent_path().parent_path() / "config";
 }
 
-int main() {
+/// Command-line options; everything else comes from config/settings.csv.
+struct CommandLine {
+    std::string capturePath;     ///< --capture FILE: journal every raw feed line
+    std::string replayPath;      ///< --replay FILE: feed a journal instead of IQFeed
+    double      replaySpeed{1.0};///< --speed X: 1 = original pacing, 0 = flat out
+    bool        exitAfterReplay{false};   ///< --exit: stop once the journal is done
+};
+
+static CommandLine parseCommandLine(int argc, char* argv[]) {
+    CommandLine cl;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if      (arg == "--capture" && hasValue) cl.capturePath = argv[++i];
+        else if (arg == "--replay"  && hasValue) cl.replayPath  = argv[++i];
+        else if (arg == "--speed"   && hasValue) cl.replaySpeed = std::stod(argv[++i]);
+        else if (arg == "--fast")                cl.replaySpeed = 0.0;
+        else if (arg == "--exit")                cl.exitAfterReplay = true;
+        else throw std::runtime_error("unknown or incomplete argument '" + std::string(arg) + "'");
+    }
+    return cl;
+}
+
+int main(int argc, char* argv[]) {
     try {
-        boost::asio::io_context ioc;
+        const CommandLine cl = parseCommandLine(argc, argv);
+        const bool replaying = !cl.replayPath.empty();
         auto configDir = getConfigDir();
 
         if (!SchemaLoader::load("L1", (configDir / "L1FeedMessages.csv").string())) return 1;
         if (!SchemaLoader::load("L2", (configDir / "MarketDepthMessages.csv").string())) return 1;
 
-        std::vector<std::string> symbols;
-        std::ifstream in(configDir / "symbols.csv");
-        if (!in.is_open()) return 1;
-        for (std::string line; std::getline(in, line); ) {
-            auto s = trim(line);
-            if (!s.empty()) symbols.push_back(s);
-        }
+        // Seeds the symbol table; tickers first seen on a feed are added as
+        // they arrive.
+        std::vector<SymbolId> symbols =
+            SymbolTable::load((configDir / "symbols.csv").string());
         if (symbols.empty()) return 1;
 
-        WebSocketServer ws(ioc, 8080);
+        Settings::load((configDir / "settings.csv").string());
+
+        // Console output goes through the async logger from here on, so
+        // feed and WebSocket threads never block on stdout.
+        Logger::setLevel(Logger::parseLevel(Settings::getString("log.level", "info")));
+        Logger::start(static_cast<std::size_t>(Settings::getInt("log.ring_size", 16384)));
+        LogSampler l1Sample(static_cast<std::uint64_t>(Settings::getInt("log.raw_sample", 1000)));
+        LogSampler l2Sample(static_cast<std::uint64_t>(Settings::getInt("log.raw_sample", 1000)));
+
+        Histogram::setSamplingInterval(
+            static_cast<std::uint32_t>(Settings::getInt("metrics.latency_sample", 16)));
+        Metrics::addCollector([](std::string& out) {
+            out += "# HELP ingest_log_dropped_total Log records dropped because the ring was full\n"
+                   "# TYPE ingest_log_dropped_total counter\n"
+                   "ingest_log_dropped_total " + std::to_string(Logger::dropped()) + "\n";
+        });
+
+        const auto wsPort = static_cast<unsigned short>(Settings::getInt("ws.port", 8080));
+        WebSocketServer::Options wsOptions;
+        wsOptions.maxQueueDepth  = static_cast<std::size_t>(
+            std::max<long long>(1, Settings::getInt("ws.max_queue_depth", 4096)));
+        wsOptions.overflowPolicy = WebSocketServer::parsePolicy(Settings::getString("ws.overflow_policy", "drop-oldest"));
+        // off | writable | <milliseconds>
+        const auto l1Conflation = Settings::getString("ws.l1_conflation", "off");
+        if (l1Conflation == "writable") wsOptions.l1ConflationMs = 0;
+        else if (l1Conflation != "off") {
+            const auto ms = Settings::getInt("ws.l1_conflation", 0);
+            if (ms > 0) wsOptions.l1ConflationMs = static_cast<int>(ms);
+            else Logger::warn("Settings: ws.l1_conflation must be off, writable or milliseconds");
+        }
+        // off | writable | <microseconds>
+        const auto batch = Settings::getString("ws.batch", "off");
+        if (batch == "writable") wsOptions.batchWindowUs = 0;
+        else if (batch != "off") {
+            const auto us = Settings::getInt("ws.batch", 0);
+            if (us > 0) wsOptions.batchWindowUs = us;
+            else Logger::warn("Settings: ws.batch must be off, writable or microseconds");
+        }
+        wsOptions.batchBytes = static_cast<std::size_t>(Settings::getInt("ws.batch_bytes", 65536));
+        wsOptions.compress         = Settings::getBool("ws.compress", false);
+        wsOptions.compressLevel    = Settings::getInt("ws.compress_level", 6);
+        wsOptions.compressMinBytes = static_cast<std::size_t>(Settings::getInt("ws.compress_min_bytes", 128));
+        wsOptions.maxClientSymbols = static_cast<std::size_t>(
+            std::max<long long>(0, Settings::getInt("ws.max_client_symbols", 10000)));
+
+        // Feeds are pinned to their own contexts so an L2 depth burst cannot
+        // delay L1 quotes; WebSocket sessions are spread over a worker pool.
+        const auto hw = std::max(1u, std::thread::hardware_concurrency());
+        const auto wsThreads = static_cast<std::size_t>(
+            std::max<long long>(1, Settings::getInt("threads.websocket", hw > 2 ? hw - 2 : 1)));
+        const auto l2Connections = static_cast<std::size_t>(
+            std::max<long long>(1, Settings::getInt("l2.connections", 1)));
+        IoContextPool feedPool(1 + l2Connections);
+        IoContextPool wsPool(wsThreads);
+        auto& l1Ioc = feedPool.at(0);   // admin + L1; at(1..) are the L2 shards
+
+        WebSocketServer ws(wsPool, wsPort, wsOptions);
         ws.start();
-        std::cout << "WebSocketServer listening on port 8080\n";
+        Logger::info("WebSocketServer listening on port ", wsPort);
+
+        // Scrapes are rare and cheap; they share a WebSocket thread.
+        std::unique_ptr<MetricsServer> metricsServer;
+        if (Settings::getBool("metrics.enabled", true)) {
+            metricsServer = std::make_unique<MetricsServer>(
+                wsPool.at(0), Settings::getString("metrics.address", "127.0.0.1"),
+                static_cast<unsigned short>(Settings::getInt("metrics.port", 9101)));
+            metricsServer->start();
+        }
+
+        // Raw capture: every line as read, before any parsing.
+        std::unique_ptr<JournalWriter> journal;
+        if (!cl.capturePath.empty()) {
+            journal = std::make_unique<JournalWriter>(cl.capturePath);
+        }
+        std::unique_ptr<JournalReader> reader;
+        if (replaying) {
+            reader = std::make_unique<JournalReader>(cl.replayPath);
+        }
 
-        ConnectionManager admin(ioc, "127.0.0.1", 9300);
+        ConnectionManager admin(l1Ioc, "127.0.0.1", 9300);
         admin.setConnectHandler([&]() { admin.send("S,SET PROTOCOL,6.2\r\n"); });
-        admin.setMessageHandler([&](const std::string& msg) {
-            std::cout << "[ADMIN] " << msg << "\n";
+        admin.setMessageHandler([&](std::string_view msg) {
+            Logger::info("[ADMIN] ", msg);
         });
-        admin.start();
+        admin.setJournal(journal.get(), JournalChannel::Admin);
 
-        bool l1sub = false, l2sub = false;
-        ConnectionManager l1(ioc, "127.0.0.1", 5009);
-        l1.setConnectHandler([&]() { l1.send("S,SET PROTOCOL,6.2\r\n"); });
-        l1.setMessageHandler([&](const std::string& raw) {
-            auto msg = trim(raw);
-            std::cout << "[L1] " << msg << "\n";
-            if (!l1sub && msg.rfind("S,SERVER CONNECTED", 0) == 0) {
-                for (auto& sym : symbols) l1.send("w" + sym + "\r\n");
-                l1sub = true;
+        // Current schemas; a reload swaps these pointers under the decoders.
+        const auto& l1Schema = SchemaLoader::current("L1");
+        const auto& l2Schema = SchemaLoader::current("L2");
+
+        // In-process depth books live in the cache, written only from the L2
+        // thread. Clients can take top-N snapshots (or level deltas) instead
+        // of raw order traffic.
+        const bool bookEnabled = Settings::getBool("book.enabled", true);
+        const bool bookDeltas  = Settings::getString("book.publish", "snapshot") == "delta";
+        const auto bookDepth   = static_cast<std::size_t>(Settings::getInt("book.depth", 10));
+        const bool l2Raw       = Settings::getBool("l2.raw", true);
+
+        // Last values per symbol, so late joiners start from a consistent
+        // snapshot instead of waiting for the next tick.
+        LastValueCache cache(*l2Schema.load());
+        auto describeSchemas = [&] {
+            return BinaryEncoder::describe({
+                {"L1", static_cast<std::uint8_t>(Feed::L1), l1Schema.load()},
+                {"L2", static_cast<std::uint8_t>(Feed::L2), l2Schema.load()},
+            });
+        };
+
+        // Co-located consumers can skip TCP and JSON: every feed thread also
+        // writes its records, binary-encoded, into a shared-memory ring of
+        // its own (one writer each, so publishing takes no lock).
+        std::unique_ptr<ShmRingWriter> l1Ring;
+        std::vector<std::unique_ptr<ShmRingWriter>> l2Rings(l2Connections);
+        if (Settings::getBool("shm.enabled", false)) {
+            const auto name  = Settings::getString("shm.name", "dtn_ingest");
+            const auto bytes = static_cast<std::size_t>(Settings::getInt("shm.ring_mb", 64)) << 20;
+            l1Ring = std::make_unique<ShmRingWriter>(name + "_L1", bytes);
+            for (std::size_t i = 0; i < l2Connections; ++i) {
+                l2Rings[i] = std::make_unique<ShmRingWriter>(name + "_L2_" + std::to_string(i), bytes);
+            }
+            Logger::info("Shared memory: ", name, "_L1 and ", l2Connections, " L2 ring(s) of ",
+                         bytes >> 20, " MiB");
+        }
+        auto publishSchemas = [&] {
+            std::string description = describeSchemas();
+            if (l1Ring) l1Ring->setSchema(description);
+            for (auto& ring : l2Rings) {
+                if (ring) ring->setSchema(description);
+            }
+            ws.setSchemaDescription(std::move(description));
+        };
+        publishSchemas();
+
+        // OHLCV/VWAP bars per symbol, built from L1 trades and published on
+        // the BARS feed as each interval completes. Closing runs on the L1
+        // thread, which also feeds it trades.
+        std::unique_ptr<BarAggregator> bars;
+        if (Settings::getBool("bars.enabled", true)) {
+            auto intervals = BarAggregator::parseIntervals(Settings::getString("bars.intervals", "1s,1m"));
+            const auto history = static_cast<std::size_t>(Settings::getInt("bars.history", 60));
+            Counter& barsPublished = Metrics::counter("ingest_bars_total", "Completed bars published");
+            if (!intervals.empty()) {
+                bars = std::make_unique<BarAggregator>(l1Ioc, std::move(intervals), history,
+                    [&ws, &barsPublished](SymbolId symbol, const BarAggregator::Interval& interval,
+                                          const Bar& bar, std::uint64_t seq) {
+                        barsPublished.inc();
+                        ws.publish(MessageTag{Feed::Bars, symbol, 0, seq}, [&] {
+                            _reuseSb.Clear();
+                            _reuseWriter.Reset(_reuseSb);
+                            BarAggregator::writeBar(_reuseWriter, SymbolTable::name(symbol),
+                                                    interval, bar, seq);
+                            return std::string_view(_reuseSb.GetString(), _reuseSb.GetSize());
+                        });
+                    });
+            }
+        }
+
+        ws.setSnapshotProvider([&](const WebSocketServer::SnapshotFilter& wants, Snapshot& snap) {
+            std::uint64_t l1Seq = 0, bookSeq = 0, barSeq = 0;
+            // deltas need the whole book to apply against
+            const std::size_t depth = bookDeltas ? SIZE_MAX : bookDepth;
+            cache.snapshot(
+                [&](SymbolId symbol) { return wants(Feed::L1, symbol); },
+                [&](SymbolId symbol) { return wants(Feed::Book, symbol); },
+                depth,
+                [&](const DecodedMessage& rec) {
+                    const auto type = rec.fields[0].text.substr(0, 1);
+                    if (snap.format == WireFormat::Binary) {
+                        // cached before a reload: its columns no longer match the description
+                        if (rec.schema != l1Schema.load()) return;
+                        const char code = type.empty() ? '\0' : type[0];
+                        snap.messages.push_back({std::string(encodeBinary(rec, Feed::L1, code, l1Seq, true)), true});
+                    } else {
+                        snap.messages.push_back({std::string(serialize(rec, "L1", type, l1Seq, true))});
+                    }
+                },
+                [&](SymbolId symbol, const OrderBook& book) {
+                    _reuseSb.Clear();
+                    _reuseWriter.Reset(_reuseSb);
+                    book.writeSnapshot(_reuseWriter, SymbolTable::name(symbol), depth, {}, bookSeq);
+                    snap.messages.push_back({std::string(_reuseSb.GetString(), _reuseSb.GetSize())});
+                },
+                l1Seq, bookSeq);
+            if (bars) {
+                bars->snapshot(snap.barHistory,
+                    [&](SymbolId symbol, const BarAggregator::Interval& interval, const Bar& bar) {
+                        if (!wants(Feed::Bars, symbol)) return;
+                        _reuseSb.Clear();
+                        _reuseWriter.Reset(_reuseSb);
+                        BarAggregator::writeBar(_reuseWriter, SymbolTable::name(symbol),
+                                                interval, bar, barSeq, true);
+                        snap.messages.push_back({std::string(_reuseSb.GetString(), _reuseSb.GetSize())});
+                    },
+                    barSeq);
+            }
+            snap.seq[static_cast<std::size_t>(Feed::L1)]   = l1Seq;
+            snap.seq[static_cast<std::size_t>(Feed::Book)] = bookSeq;
+            snap.seq[static_cast<std::size_t>(Feed::Bars)] = barSeq;
+            snap.messages.push_back({
+                "{\"feed\":\"SNAPSHOT\",\"type\":\"end\",\"seq\":{\"L1\":" +
+                std::to_string(l1Seq) + ",\"BOOK\":" + std::to_string(bookSeq) +
+                ",\"BARS\":" + std::to_string(barSeq) + "}}"});
+        });
+
+        FeedMetrics l1Metrics("L1"), l2Metrics("L2");
+        Histogram& jsonLatency = Metrics::histogram("ingest_serialize_seconds",
+            "Time to encode one record for clients (sampled)", "format=\"json\"");
+        Histogram& binLatency  = Metrics::histogram("ingest_serialize_seconds",
+            "Time to encode one record for clients (sampled)", "format=\"binary\"");
+
+        // Conflating sessions are sent the cache's merged record per symbol,
+        // so fields a skipped update carried are not lost.
+        ws.setConflationProvider([&](SymbolId symbol, WireFormat format,
+                                     std::uint64_t haveSeq, std::string& out) {
+            std::uint64_t seq = haveSeq;
+            bool stale = false;
+            cache.latestL1(symbol, seq, [&](const DecodedMessage& rec) {
+                const auto type = rec.fields[0].text.substr(0, 1);
+                if (format == WireFormat::Binary) {
+                    if ((stale = rec.schema != l1Schema.load())) return;   // as in snapshots
+                    out.assign(encodeBinary(rec, Feed::L1, type.empty() ? '\0' : type[0], seq));
+                } else {
+                    out.assign(serialize(rec, "L1", type, seq));
+                }
+            });
+            return stale ? 0 : seq;
+        });
+
+        // Decode → cache → publish, shared by the live feeds and replay.
+        // Each runs on one thread at a time (its feed thread, or the replay
+        // thread), so the thread-local scratch needs no locking.
+        auto onL1Line = [&](std::string_view msg) {
+            if (msg.empty() || (!isdigit(msg[0]) && msg[0] != 'Q')) {
+                l1Metrics.skipped.inc();
                 return;
             }
-            if (msg.rfind("S,KEY,", 0) == 0) {
-                l1.send(msg + "\r\n");
+            bool decoded;
+            {
+                ScopedTimer t(l1Metrics.decode.sample());
+                decoded = MessageDecoder::decode(*l1Schema.load(std::memory_order_acquire), msg, _reuseMsg);
+            }
+            if (!decoded) {
+                l1Metrics.decodeErrors.inc();
                 return;
             }
-            if (msg.empty() || (!isdigit(msg[0]) && msg[0] != 'Q')) {
+            l1Metrics.decoded.inc();
+            const auto seq = cache.updateL1(_reuseMsg);
+            if (l1Ring) l1Ring->publish(encodeBinary(_reuseMsg, Feed::L1, msg[0], seq));
+            // only serialized if some session wants this symbol and type
+            ws.publish(MessageTag{Feed::L1, _reuseMsg.symbol, msg[0], seq, symbolKey(Feed::L1)},
+                       [&] {
+                           ScopedTimer t(jsonLatency.sample());
+                           return serialize(_reuseMsg, "L1", msg.substr(0, 1), seq);
+                       },
+                       [&]() -> std::string_view {
+                           if (l1Ring) return _reuseBin;   // encoded for the ring above
+                           ScopedTimer t(binLatency.sample());
+                           return encodeBinary(_reuseMsg, Feed::L1, msg[0], seq);
+                       });
+            if (bars) bars->apply(_reuseMsg);
+        };
+
+        std::atomic<std::uint64_t> l2Seq{0};   // raw L2 rows, across every shard
+        auto onL2Line = [&](std::string_view msg, ShmRingWriter* ring) {
+            if (msg.empty() || (msg[0] < '0' || msg[0] > '9')) {
+                l2Metrics.skipped.inc();
                 return;
             }
-            _reuseDoc.SetObject();
-            if (!MessageDecoder::decode(SchemaLoader::fields("L1"), msg, _reuseDoc)) {
+            bool decoded;
+            {
+                ScopedTimer t(l2Metrics.decode.sample());
+                decoded = MessageDecoder::decode(*l2Schema.load(std::memory_order_acquire), msg, _reuseMsg);
+            }
+            if (!decoded) {
+                l2Metrics.decodeErrors.inc();
                 return;
             }
-            // Remove duplicate message type field from schema, if present
-            auto& a = _reuseDoc.GetAllocator();
-            _reuseDoc.AddMember("feed", "L1", a);
-            _reuseDoc.AddMember("messageType", rapidjson::Value(std::string(1, msg[0]).c_str(), a), a);
-            _reuseSb.Clear();
-            _reuseWriter.Reset(_reuseSb);
-            _reuseDoc.Accept(_reuseWriter);
-            ws.broadcast(_reuseSb.GetString());
-        });
-        l1.start();
-
-        ConnectionManager l2(ioc, "127.0.0.1", 9200);
-        l2.setConnectHandler([&]() { l2.send("S,SET PROTOCOL,6.2\r\n"); });
-        l2.setMessageHandler([&](const std::string& raw) {
-            auto msg = trim(raw);
-            std::cout << "[L2] " << msg << "\n";
-            if (!l2sub && msg.rfind("S,SERVER CONNECTED", 0) == 0) {
-                for (auto& sym : symbols) l2.send("WOR," + sym + "\r\n");
-                l2sub = true;
+            l2Metrics.decoded.inc();
+            if (bookEnabled) {
+                std::uint64_t seq = 0;
+                OrderBook* book = cache.applyL2(_reuseMsg, seq);
+                if (book && (bookDeltas || book->topChanged(bookDepth))) {
+                    const auto sym = SymbolTable::name(_reuseMsg.symbol);
+                    // a newer snapshot supersedes a queued one; deltas must all arrive
+                    const MessageTag tag{Feed::Book, _reuseMsg.symbol, 0, seq, bookDeltas ? 0 : symbolKey(Feed::Book)};
+                    ws.publish(tag, [&] {
+                        _reuseSb.Clear();
+                        _reuseWriter.Reset(_reuseSb);
+                        if (bookDeltas) book->writeDelta(_reuseWriter, sym, _reuseMsg.timestamp, seq);
+                        else            book->writeSnapshot(_reuseWriter, sym, bookDepth, _reuseMsg.timestamp, seq);
+                        return std::string_view(_reuseSb.GetString(), _reuseSb.GetSize());
+                    });
+                }
+            }
+            const auto seq = l2Seq.fetch_add(1, std::memory_order_relaxed) + 1;
+            if (ring) ring->publish(encodeBinary(_reuseMsg, Feed::L2, msg[0], seq));
+            if (!l2Raw) {
                 return;
             }
-            if (msg.empty() || (msg[0] < '0' || msg[0] > '9')) {
+            ws.publish(MessageTag{Feed::L2, _reuseMsg.symbol, msg[0], seq},
+                       [&] {
+                           ScopedTimer t(jsonLatency.sample());
+                           return serialize(_reuseMsg, "L2", msg.substr(0, 1), seq);
+                       },
+                       [&]() -> std::string_view {
+                           if (ring) return _reuseBin;
+                           ScopedTimer t(binLatency.sample());
+                           return encodeBinary(_reuseMsg, Feed::L2, msg[0], seq);
+                       });
+        };
+
+        // Subscriptions are paced and re-sent after every reconnect.
+        SubscriptionManager::Options subOptions;
+        subOptions.batchSize = static_cast<std::size_t>(Settings::getInt("subs.batch_size", 500));
+        subOptions.interval  = std::chrono::milliseconds(Settings::getInt("subs.interval_ms", 100));
+
+        // "n,<symbol>": the server does not know the symbol.
+        auto rejectedSymbol = [](std::string_view msg) {
+            return msg.rfind("n,", 0) == 0 ? SymbolTable::find(msg.substr(2)) : kNoSymbol;
+        };
+
+        ConnectionManager l1(l1Ioc, "127.0.0.1", 5009);
+        SubscriptionManager l1Subs(l1Ioc, l1, "L1", "w", "r", subOptions);
+        l1.setConnectHandler([&]() { l1.send("S,SET PROTOCOL,6.2\r\n"); });
+        l1.setDisconnectHandler([&]() { l1Subs.onDisconnected(); });
+        l1.setMessageHandler([&](std::string_view raw) {
+            auto msg = trimView(raw);
+            if (Logger::enabled(LogLevel::Debug) && l1Sample()) Logger::debug("[L1] ", msg);
+            if (msg.rfind("S,SERVER CONNECTED", 0) == 0) {
+                l1Subs.onConnected();
                 return;
             }
-            _reuseDoc.SetObject();
-            if (!MessageDecoder::decode(SchemaLoader::fields("L2"), msg, _reuseDoc)) {
+            if (msg.rfind("S,KEY,", 0) == 0) {
+                l1.send(std::string(msg) + "\r\n");
+                return;
+            }
+            if (const SymbolId rejected = rejectedSymbol(msg); rejected != kNoSymbol) {
+                l1Subs.onRejected(rejected);
                 return;
             }
-            // Remove duplicate message type field from schema, if present
-            _reuseDoc.RemoveMember("Message Type");
-            auto& a2 = _reuseDoc.GetAllocator();
-            _reuseDoc.AddMember("feed", "L2", a2);
-            _reuseDoc.AddMember("messageType", rapidjson::Value(std::string(1, msg[0]).c_str(), a2), a2);
-            _reuseSb.Clear();
-            _reuseWriter.Reset(_reuseSb);
-            _reuseDoc.Accept(_reuseWriter);
-            ws.broadcast(_reuseSb.GetString());
+            onL1Line(msg);
         });
-        l2.start();
+        l1.setJournal(journal.get(), JournalChannel::L1);
+
+        // Depth is sharded by symbol id over several connections, each read
+        // and decoded on its own thread. A symbol always maps to the same
+        // shard, so its rows stay in order.
+        std::vector<std::unique_ptr<L2Shard>> l2Shards;
+        for (std::size_t i = 0; i < l2Connections; ++i) {
+            l2Shards.push_back(std::make_unique<L2Shard>(feedPool.at(1 + i), i, subOptions));
+            L2Shard& shard = *l2Shards.back();
+            shard.conn.setConnectHandler([&shard]() { shard.conn.send("S,SET PROTOCOL,6.2\r\n"); });
+            shard.conn.setDisconnectHandler([&shard]() { shard.subs.onDisconnected(); });
+            shard.conn.setMessageHandler([&, ring = l2Rings[i].get()](std::string_view raw) {
+                auto msg = trimView(raw);
+                if (Logger::enabled(LogLevel::Debug) && l2Sample()) Logger::debug("[L2] ", msg);
+                if (msg.rfind("S,SERVER CONNECTED", 0) == 0) {
+                    shard.subs.onConnected();
+                    return;
+                }
+                if (const SymbolId rejected = rejectedSymbol(msg); rejected != kNoSymbol) {
+                    shard.subs.onRejected(rejected);
+                    return;
+                }
+                onL2Line(msg, ring);
+            });
+            shard.conn.setJournal(journal.get(), JournalChannel::L2);
+        }
+        auto l2SubsFor = [&](SymbolId sym) -> SubscriptionManager& {
+            return l2Shards[sym % l2Shards.size()]->subs;
+        };
+
+        for (SymbolId sym : symbols) {
+            l1Subs.subscribe(sym);
+            l2SubsFor(sym).subscribe(sym);
+        }
+
+        // Config hot reload: schema edits are swapped in under the decoders;
+        // symbols.csv edits become incremental subscribe/unsubscribe commands.
+        std::unique_ptr<ConfigWatcher> watcher;
+        if (const auto pollMs = Settings::getInt("reload.poll_ms", 1000); pollMs > 0) {
+            watcher = std::make_unique<ConfigWatcher>(wsPool.at(0), std::chrono::milliseconds(pollMs));
+            auto reloadSchema = [&](const char* id, const char* file) {
+                const Schema* before = SchemaLoader::current(id).load();
+                if (SchemaLoader::load(id, (configDir / file).string()) &&
+                    SchemaLoader::current(id).load() != before) {
+                    publishSchemas();
+                }
+            };
+            watcher->watch(configDir / "L1FeedMessages.csv",
+                           [=] { reloadSchema("L1", "L1FeedMessages.csv"); });
+            watcher->watch(configDir / "MarketDepthMessages.csv",
+                           [=] { reloadSchema("L2", "MarketDepthMessages.csv"); });
+            watcher->watch(configDir / "symbols.csv", [&] {
+                auto next = SymbolTable::load((configDir / "symbols.csv").string());
+                if (next.empty()) {
+                    Logger::warn("Reload: symbols.csv is empty, keeping ", symbols.size(), " symbols");
+                    return;
+                }
+                std::vector<bool> was(SymbolTable::size()), now(SymbolTable::size());
+                for (SymbolId sym : symbols) was[sym] = true;
+                for (SymbolId sym : next)    now[sym] = true;
+                std::size_t added = 0, removed = 0;
+                for (SymbolId sym : next) {
+                    if (was[sym]) continue;
+                    l1Subs.subscribe(sym);
+                    l2SubsFor(sym).subscribe(sym);
+                    ++added;
+                }
+                for (SymbolId sym : symbols) {
+                    if (now[sym]) continue;
+                    l1Subs.unsubscribe(sym);
+                    l2SubsFor(sym).unsubscribe(sym);
+                    ++removed;
+                }
+                symbols = std::move(next);
+                Logger::info("Reload: ", added, " symbols added, ", removed, " removed");
+            });
+            watcher->start();
+        }
+        if (bars) bars->start();
 
-        ioc.run();
+        if (!replaying) {
+            admin.start();
+            l1.start();
+            for (auto& shard : l2Shards) shard->conn.start();
+        }
+
+        Logger::info("Running with ", feedPool.size(), " feed threads (", l2Shards.size(),
+                     " L2 connections) and ", wsPool.size(),
+                     " WebSocket threads", replaying ? " (replay)" : "");
+        wsPool.start();
+        feedPool.start();
+
+        // Replay drives the same line handlers from one thread, in journal
+        // order, instead of connecting to IQFeed.
+        std::thread replayThread;
+        if (replaying) {
+            replayThread = std::thread([&] {
+                const auto t0 = std::chrono::steady_clock::now();
+                const std::size_t n = reader->replay(
+                    [&](JournalChannel ch, std::string_view raw) {
+                        const auto msg = trimView(raw);
+                        if (ch == JournalChannel::L1)      onL1Line(msg);
+                        else if (ch == JournalChannel::L2) onL2Line(msg, l2Rings[0].get());
+                    },
+                    cl.replaySpeed);
+                const double secs = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - t0).count();
+                Logger::info("Replay: ", n, " lines in ", secs, " s (",
+                             secs > 0 ? n / secs : 0.0, " lines/s)");
+                if (cl.exitAfterReplay) feedPool.stop();
+            });
+        }
+        feedPool.join();
+        if (replayThread.joinable()) replayThread.join();
+        wsPool.stop();
+        wsPool.join();
+        if (journal) journal->close();
+        Logger::stop();
         return 0;
     }
     catch (const std::exception& ex) {
-        std::cerr << "Fatal error: " << ex.what() << "\n";
+        Logger::error("Fatal error: ", ex.what());
+        Logger::stop();
         return 1;
     }
 }
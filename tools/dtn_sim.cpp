@@ -0,0 +1,354 @@
+// File: tools/dtn_sim.cpp
+//
+// Stand-in for the IQFeed admin (9300), Level 1 (5009) and Level 2 (9200)
+// servers on localhost, for load-testing ingest_server without a DTN
+// licence. Answers the commands ingest_server and AuthManager send and
+// streams synthetic Q (L1) and order add/modify/remove (L2) rows.
+//
+//   dtn_sim [--l1-rate N] [--l2-rate N] [--symbols N] [--seed N]
+//           [--admin-port P] [--l1-port P] [--l2-port P]
+//
+// Rates are messages per second across all symbols. Traffic goes to the
+// symbols each client subscribed to plus --symbols synthetic ones
+// (SIM0000, SIM0001, ...), so load does not depend on symbols.csv.
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace asio = boost::asio;
+using tcp = asio::ip::tcp;
+
+namespace {
+
+struct SimOptions {
+    double         l1Rate{1000};
+    double         l2Rate{5000};
+    std::size_t    symbols{0};
+    unsigned       seed{42};
+    unsigned short adminPort{9300};
+    unsigned short l1Port{5009};
+    unsigned short l2Port{9200};
+};
+
+enum class Role { Admin, L1, L2 };
+
+/// "HH:MM:SS.ffffff" and "YYYY-MM-DD" for now, in UTC.
+void stamp(char (&time)[32], char (&date)[32]) {
+    const auto now  = std::chrono::system_clock::now();
+    const auto secs = std::chrono::system_clock::to_time_t(now);
+    const auto us   = std::chrono::duration_cast<std::chrono::microseconds>(
+                          now.time_since_epoch()).count() % 1000000;
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &secs);
+#else
+    gmtime_r(&secs, &tm);
+#endif
+    std::snprintf(time, sizeof time, "%02d:%02d:%02d.%06d",
+                  tm.tm_hour, tm.tm_min, tm.tm_sec, static_cast<int>(us));
+    std::snprintf(date, sizeof date, "%04d-%02d-%02d",
+                  tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday);
+}
+
+/// Per-symbol synthetic state: a drifting quote and a set of live orders.
+struct SymbolState {
+    struct Order {
+        std::uint64_t id;
+        char          side;
+        double        price;
+        long          size;
+    };
+
+    double             mid{50.0};
+    double             last{50.0};     ///< most recent trade price
+    long               lastSize{0};
+    long long          volume{0};
+    std::vector<Order> orders;
+};
+
+/// One client connection: line-oriented reads, queued writes, and a
+/// generator tick for feed roles.
+class SimSession : public std::enable_shared_from_this<SimSession> {
+public:
+    SimSession(tcp::socket socket, Role role, const SimOptions& opts)
+      : socket_(std::move(socket)),
+        timer_(socket_.get_executor()),
+        role_(role),
+        opts_(opts),
+        rng_(opts.seed + static_cast<unsigned>(role))
+    {
+        for (std::size_t i = 0; i < opts_.symbols; ++i) {
+            char name[32];
+            std::snprintf(name, sizeof name, "SIM%04zu", i);
+            watch(name);
+        }
+    }
+
+    void start() {
+        if (role_ != Role::Admin) {
+            write("S,KEY,SIMULATOR\r\n");
+            write("S,SERVER CONNECTED\r\n");
+            last_ = std::chrono::steady_clock::now();
+            tick();
+        }
+        doRead();
+    }
+
+private:
+    void doRead() {
+        asio::async_read_until(socket_, input_, '\n',
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t n) {
+                if (ec) { self->close(); return; }
+                std::string line(asio::buffers_begin(self->input_.data()),
+                                 asio::buffers_begin(self->input_.data()) + n);
+                self->input_.consume(n);
+                while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+                self->onLine(line);
+                self->doRead();
+            });
+    }
+
+    void onLine(const std::string& line) {
+        if (line.rfind("S,SET PROTOCOL,", 0) == 0) {
+            write("S,CURRENT PROTOCOL," + line.substr(15) + "\r\n");
+        } else if (line.rfind("LOGIN,", 0) == 0) {
+            write("OK\n");                               // what AuthManager expects
+        } else if (line.rfind("S,KEY,", 0) == 0) {
+            // key echo from the client; nothing to do
+        } else if (role_ == Role::L1 && line.size() > 1 && line[0] == 'w') {
+            watch(line.substr(1));
+        } else if (role_ == Role::L1 && line.size() > 1 && line[0] == 'r') {
+            unwatch(line.substr(1));
+        } else if (role_ == Role::L2 && line.rfind("WOR,", 0) == 0) {
+            watch(line.substr(4));
+        } else if (role_ == Role::L2 && line.rfind("ROR,", 0) == 0) {
+            unwatch(line.substr(4));
+        } else if (!line.empty()) {
+            write("E,!SYNTAX_ERROR!," + line + "\r\n");
+        }
+    }
+
+    void watch(const std::string& symbol) {
+        if (symbol.empty() || state_.count(symbol)) return;
+        SymbolState s;
+        s.mid = std::uniform_real_distribution<double>(5.0, 500.0)(rng_);
+        state_.emplace(symbol, std::move(s));
+        symbols_.push_back(symbol);
+    }
+
+    void unwatch(const std::string& symbol) {
+        if (!state_.erase(symbol)) return;
+        symbols_.erase(std::find(symbols_.begin(), symbols_.end(), symbol));
+    }
+
+    /// Every millisecond, emit however many rows the rate calls for.
+    void tick() {
+        timer_.expires_after(std::chrono::milliseconds(1));
+        timer_.async_wait([self = shared_from_this()](boost::system::error_code ec) {
+            if (ec || self->closed_) return;
+            const auto now = std::chrono::steady_clock::now();
+            const double secs = std::chrono::duration<double>(now - self->last_).count();
+            self->last_ = now;
+            const double rate = self->role_ == Role::L1 ? self->opts_.l1Rate : self->opts_.l2Rate;
+            self->owed_ += rate * secs;
+            if (!self->symbols_.empty() && self->owed_ >= 1.0) {
+                std::string batch;
+                char time[32], date[32];
+                stamp(time, date);
+                for (; self->owed_ >= 1.0; self->owed_ -= 1.0) {
+                    if (self->role_ == Role::L1) self->quote(batch, time);
+                    else                         self->order(batch, time, date);
+                }
+                // A client that cannot keep up should see backpressure, not
+                // an ever-growing queue in the simulator.
+                if (self->pending_ < (64u << 20)) self->write(std::move(batch));
+            } else if (self->symbols_.empty()) {
+                self->owed_ = 0;
+            }
+            self->tick();
+        });
+    }
+
+    SymbolState& pick(const std::string*& symbol) {
+        symbol = &symbols_[std::uniform_int_distribution<std::size_t>(0, symbols_.size() - 1)(rng_)];
+        return state_[*symbol];
+    }
+
+    void quote(std::string& out, const char* time) {
+        const std::string* sym;
+        SymbolState& s = pick(sym);
+        s.mid *= 1.0 + std::normal_distribution<double>(0.0, 0.0005)(rng_);
+        const long size = std::uniform_int_distribution<long>(1, 50)(rng_) * 100;
+        // About one row in three is a trade (Message Contents 'C'); the rest
+        // only move the quote and leave the last trade as it was.
+        const bool trade = std::uniform_int_distribution<int>(0, 2)(rng_) == 0;
+        if (trade) {
+            s.last     = s.mid;
+            s.lastSize = size;
+            s.volume  += size;
+        }
+        const double spread = 0.01;
+        char row[256];
+        const int n = std::snprintf(row, sizeof row,
+            "Q,%s,%.2f,%ld,%s,11,%lld,%.2f,%ld,%.2f,%ld,%.2f,%.2f,%.2f,%.2f,%s,01\r\n",
+            sym->c_str(), s.last, s.lastSize, time, s.volume,
+            s.mid - spread, size, s.mid + spread, size,
+            s.mid, s.mid * 1.01, s.mid * 0.99, s.mid, trade ? "Cba" : "ba");
+        out.append(row, static_cast<std::size_t>(n));
+    }
+
+    void order(std::string& out, const char* time, const char* date) {
+        const std::string* sym;
+        SymbolState& s = pick(sym);
+        const int dice = std::uniform_int_distribution<int>(0, 9)(rng_);
+        char row[256];
+        int n;
+        if (s.orders.empty() || (dice < 5 && s.orders.size() < 200)) {
+            // add
+            const char side = dice % 2 ? 'B' : 'A';
+            const double offset = 0.01 * std::uniform_int_distribution<int>(1, 20)(rng_);
+            SymbolState::Order o{nextOrderId_++, side,
+                                 side == 'B' ? s.mid - offset : s.mid + offset,
+                                 std::uniform_int_distribution<long>(1, 10)(rng_) * 100};
+            s.orders.push_back(o);
+            n = std::snprintf(row, sizeof row, "3,%s,%llu,MMID,%c,%.2f,%ld,%llu,,%s,%s\r\n",
+                              sym->c_str(), static_cast<unsigned long long>(o.id), o.side,
+                              o.price, o.size, static_cast<unsigned long long>(o.id),
+                              time, date);
+        } else {
+            const std::size_t i = std::uniform_int_distribution<std::size_t>(0, s.orders.size() - 1)(rng_);
+            SymbolState::Order& o = s.orders[i];
+            if (dice < 8) {
+                // modify size
+                o.size = std::uniform_int_distribution<long>(1, 10)(rng_) * 100;
+                n = std::snprintf(row, sizeof row, "4,%s,%llu,MMID,%c,%.2f,%ld,%llu,,%s,%s\r\n",
+                                  sym->c_str(), static_cast<unsigned long long>(o.id), o.side,
+                                  o.price, o.size, static_cast<unsigned long long>(o.id),
+                                  time, date);
+            } else {
+                // remove: IQFeed omits the MMID and price..date columns
+                n = std::snprintf(row, sizeof row, "5,%s,%llu,%c\r\n",
+                                  sym->c_str(), static_cast<unsigned long long>(o.id), o.side);
+                o = s.orders.back();
+                s.orders.pop_back();
+            }
+        }
+        out.append(row, static_cast<std::size_t>(n));
+    }
+
+    void write(std::string data) {
+        if (closed_ || data.empty()) return;
+        pending_ += data.size();
+        queue_.push_back(std::move(data));
+        if (queue_.size() == 1) doWrite();
+    }
+
+    void doWrite() {
+        asio::async_write(socket_, asio::buffer(queue_.front()),
+            [self = shared_from_this()](boost::system::error_code ec, std::size_t) {
+                if (ec) { self->close(); return; }
+                self->pending_ -= self->queue_.front().size();
+                self->queue_.pop_front();
+                if (!self->queue_.empty()) self->doWrite();
+            });
+    }
+
+    void close() {
+        if (closed_) return;
+        closed_ = true;
+        boost::system::error_code ignored;
+        timer_.cancel();
+        socket_.close(ignored);
+        std::cout << "dtn_sim: client disconnected\n";
+    }
+
+    tcp::socket                                  socket_;
+    asio::steady_timer                           timer_;
+    asio::streambuf                              input_;
+    Role                                         role_;
+    const SimOptions&                            opts_;
+    std::mt19937_64                              rng_;
+    std::unordered_map<std::string, SymbolState> state_;
+    std::vector<std::string>                     symbols_;
+    std::deque<std::string>                      queue_;
+    std::size_t                                  pending_{0};
+    double                                       owed_{0};
+    std::chrono::steady_clock::time_point        last_;
+    std::uint64_t                                nextOrderId_{1};
+    bool                                         closed_{false};
+};
+
+/// Accepts clients for one role on one port.
+class SimListener {
+public:
+    SimListener(asio::io_context& ioc, unsigned short port, Role role, const SimOptions& opts)
+      : acceptor_(ioc, tcp::endpoint{asio::ip::make_address("127.0.0.1"), port}),
+        role_(role),
+        opts_(opts)
+    {
+        doAccept();
+    }
+
+private:
+    void doAccept() {
+        acceptor_.async_accept([this](boost::system::error_code ec, tcp::socket sock) {
+            if (!ec) {
+                std::cout << "dtn_sim: client connected on port "
+                          << acceptor_.local_endpoint().port() << "\n";
+                std::make_shared<SimSession>(std::move(sock), role_, opts_)->start();
+            }
+            doAccept();
+        });
+    }
+
+    tcp::acceptor     acceptor_;
+    Role              role_;
+    const SimOptions& opts_;
+};
+
+SimOptions parseArgs(int argc, char* argv[]) {
+    SimOptions o;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        const char* v = argv[i + 1];
+        if      (arg == "--l1-rate")    o.l1Rate    = std::stod(v);
+        else if (arg == "--l2-rate")    o.l2Rate    = std::stod(v);
+        else if (arg == "--symbols")    o.symbols   = std::stoul(v);
+        else if (arg == "--seed")       o.seed      = static_cast<unsigned>(std::stoul(v));
+        else if (arg == "--admin-port") o.adminPort = static_cast<unsigned short>(std::stoul(v));
+        else if (arg == "--l1-port")    o.l1Port    = static_cast<unsigned short>(std::stoul(v));
+        else if (arg == "--l2-port")    o.l2Port    = static_cast<unsigned short>(std::stoul(v));
+        else throw std::runtime_error("unknown argument '" + arg + "'");
+    }
+    return o;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const SimOptions opts = parseArgs(argc, argv);
+        asio::io_context ioc(1);
+        SimListener admin(ioc, opts.adminPort, Role::Admin, opts);
+        SimListener l1(ioc,    opts.l1Port,    Role::L1,    opts);
+        SimListener l2(ioc,    opts.l2Port,    Role::L2,    opts);
+        std::cout << "dtn_sim: admin " << opts.adminPort << ", L1 " << opts.l1Port
+                  << " (" << opts.l1Rate << "/s), L2 " << opts.l2Port
+                  << " (" << opts.l2Rate << "/s), " << opts.symbols << " synthetic symbols\n";
+        ioc.run();
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "dtn_sim: " << ex.what() << "\n";
+        return 1;
+    }
+}
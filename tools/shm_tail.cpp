@@ -0,0 +1,58 @@
+// File: tools/shm_tail.cpp
+//
+// Minimal shared-memory consumer: follows one ingest_server ring and
+// prints a line per second with the records received and the records
+// lost to overruns.
+//
+//   shm_tail [--name dtn_ingest_L1] [--print]
+//
+// --print also dumps feed/type/seq of every record. Link against
+// ingest_shm; nothing else from the server is needed.
+#include "ShmRing.h"
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+int main(int argc, char* argv[]) {
+    try {
+        std::string name = "dtn_ingest_L1";
+        bool print = false;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if      (arg == "--name" && i + 1 < argc) name  = argv[++i];
+            else if (arg == "--print")                print = true;
+            else throw std::runtime_error("unknown argument '" + arg + "'");
+        }
+
+        ShmRingReader ring(name);
+        std::cout << "shm_tail: following " << name << "\n" << ring.schema() << "\n";
+
+        ShmRingReader::Record rec;
+        std::uint64_t count = 0;
+        auto nextReport = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (!ring.closed()) {
+            if (ring.next(rec)) {
+                ++count;
+                if (print) {
+                    std::cout << unsigned(rec.feed) << ' ' << rec.messageType
+                              << ' ' << rec.seq << '\n';
+                }
+                continue;
+            }
+            if (std::chrono::steady_clock::now() >= nextReport) {
+                std::cout << "shm_tail: " << count << " records, " << ring.lost() << " lost\n";
+                count = 0;
+                nextReport += std::chrono::seconds(1);
+            }
+            std::this_thread::yield();
+        }
+        std::cout << "shm_tail: writer closed the ring\n";
+        return 0;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "shm_tail: " << ex.what() << "\n";
+        return 1;
+    }
+}